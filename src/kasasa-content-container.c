@@ -25,8 +25,20 @@
 #include "kasasa-content-container.h"
 
 #include "kasasa-window.h"
+#include "kasasa-settings.h"
+#include "kasasa-content-item.h"
+#include "kasasa-memory-budget.h"
 #include "kasasa-screenshot.h"
 #include "kasasa-screencast.h"
+#include "kasasa-region-selector.h"
+
+// Time between checks for the first frame of a region screencast, and the
+// number of checks before giving up
+#define REGION_FRAME_CHECK_INTERVAL 100   // miliseconds
+#define REGION_FRAME_N_CHECKS       50
+
+// Frames per second shown by screencasts while the window is miniaturized
+#define MINIATURIZED_FRAME_RATE 1
 
 struct _KasasaContentContainer
 {
@@ -38,9 +50,16 @@ struct _KasasaContentContainer
   GtkButton               *retake_screenshot_button;
   GtkButton               *add_screenshot_button;
   GtkButton               *add_delayed_screenshot_button;
+  GtkButton               *add_regions_button;
   GtkButton               *add_screencast_button;
+  GtkButton               *add_screencast_region_button;
+  GtkButton               *duplicate_screencast_button;
   GtkButton               *remove_content_button;
   GtkButton               *copy_screenshot_button;
+  GtkButton               *freeze_frame_button;
+  GtkToggleButton         *watch_button;
+  GtkMenuButton           *refresh_button;
+  GtkSpinButton           *refresh_interval_spin;
   GtkMenuButton           *more_actions_button;
   GtkRevealer             *revealer_end_buttons;
   GtkRevealer             *revealer_start_buttons;
@@ -50,12 +69,255 @@ struct _KasasaContentContainer
   /* Instance variables */
   XdpPortal               *portal;
   XdpParent               *parent;
-  GSettings               *settings;
+  KasasaSettings          *settings;
+  // KasasaContentItem descriptors, one for each (AdwBin) page of the carousel
+  GListStore              *contents;
+  // File of the capture being split into regions
+  gchar                   *regions_uri;
+  // Region screencasts: the next session asks for a region, which is selected
+  // on the first frame of this screencast
+  gboolean                 select_screencast_region;
+  KasasaScreencast        *selecting_screencast;
+  guint                    region_frame_source;
+  guint                    n_region_frame_checks;
+  // Position of the frame shown by the region selector in the whole frame;
+  // the selected regions are relative to it
+  graphene_point_t         region_frame_origin;
+  // Center of the last update_materialized_contents () (G_MAXUINT for none)
+  guint                    materialized_center;
 };
 
 G_DEFINE_FINAL_TYPE (KasasaContentContainer, kasasa_content_container, ADW_TYPE_BREAKPOINT_BIN)
 
 static GtkWidget * get_current_content (KasasaContentContainer *self);
+static void on_position_changed (GObject    *object,
+                                 GParamSpec *pspec,
+                                 gpointer    user_data);
+
+
+
+/******************************* CONTENT MODEL ********************************/
+/*
+ * Each page of the carousel is an empty AdwBin slot, and each slot has a
+ * KasasaContentItem at the same position of the 'contents' list. Only the
+ * current page and its neighbors hold a real KasasaScreenshot widget;
+ * screencasts can't be rebuilt from their descriptors, so they're kept while
+ * they are running.
+ */
+static KasasaContentItem *
+get_item (KasasaContentContainer *self,
+          guint                   position)
+{
+  KasasaContentItem *item = g_list_model_get_item (G_LIST_MODEL (self->contents),
+                                                   position);
+
+  // The list store keeps its own reference
+  if (item != NULL)
+    g_object_unref (item);
+
+  return item;
+}
+
+static guint
+get_current_position (KasasaContentContainer *self)
+{
+  return (guint) round (adw_carousel_get_position (self->carousel));
+}
+
+// Returns FALSE if the widget doesn't belong to any item
+static gboolean
+find_item (KasasaContentContainer *self,
+           GtkWidget              *widget,
+           guint                  *position)
+{
+  guint n_items = g_list_model_get_n_items (G_LIST_MODEL (self->contents));
+
+  for (guint i = 0; i < n_items; i++)
+    {
+      if (kasasa_content_item_get_widget (get_item (self, i)) == widget)
+        {
+          *position = i;
+          return TRUE;
+        }
+    }
+
+  return FALSE;
+}
+
+// Whether another item shows a region of the capture at uri
+static gboolean
+is_capture_shared (KasasaContentContainer *self,
+                   const gchar            *uri,
+                   KasasaContentItem      *except)
+{
+  guint n_items = g_list_model_get_n_items (G_LIST_MODEL (self->contents));
+
+  for (guint i = 0; i < n_items; i++)
+    {
+      KasasaContentItem *item = get_item (self, i);
+
+      if (item != except
+          && kasasa_content_item_get_region (item) != NULL
+          && g_strcmp0 (kasasa_content_item_get_uri (item), uri) == 0)
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+/*
+ * The regions of a capture share its file, which is trashed (if requested)
+ * with the last of them; call it before the item stops showing the region
+ */
+static void
+release_capture (KasasaContentContainer *self,
+                 KasasaContentItem      *item)
+{
+  KasasaWindow *window = kasasa_window_get_window_reference (GTK_WIDGET (self));
+  const gchar *uri = kasasa_content_item_get_uri (item);
+  g_autoptr (GFile) file = NULL;
+
+  if (kasasa_content_item_get_region (item) == NULL
+      || uri == NULL
+      || !kasasa_window_get_trash_button_active (window)
+      || is_capture_shared (self, uri, item))
+    return;
+
+  file = g_file_new_for_uri (uri);
+  kasasa_screenshot_trash_file (file);
+}
+
+static void
+materialize_item (KasasaContentContainer *self,
+                  guint                   position)
+{
+  KasasaContentItem *item = get_item (self, position);
+  KasasaScreenshot *screenshot = NULL;
+  GtkWidget *slot = NULL;
+  gint height, width;
+
+  if (item == NULL || kasasa_content_item_get_widget (item) != NULL)
+    return;
+
+  g_debug ("Materializing content at index %d", position);
+
+  screenshot = kasasa_screenshot_new ();
+  slot = adw_carousel_get_nth_page (self->carousel, position);
+  adw_bin_set_child (ADW_BIN (slot), GTK_WIDGET (screenshot));
+
+  if (kasasa_content_item_get_region (item) != NULL)
+    kasasa_screenshot_show_region (screenshot,
+                                   kasasa_content_item_get_region (item));
+  else
+    {
+      // The image is decoded in a thread, so keep the size it had meanwhile
+      kasasa_content_item_get_dimensions (item, &height, &width);
+      kasasa_screenshot_restore_screenshot (screenshot,
+                                            kasasa_content_item_get_uri (item),
+                                            height,
+                                            width);
+    }
+  kasasa_content_item_set_widget (item, GTK_WIDGET (screenshot));
+}
+
+static void
+release_item (KasasaContentContainer *self,
+              guint                   position)
+{
+  KasasaContentItem *item = get_item (self, position);
+  GtkWidget *slot = NULL;
+
+  if (item == NULL
+      || kasasa_content_item_get_widget (item) == NULL
+      || kasasa_content_item_get_content_type (item) != CONTENT_TYPE_SCREENSHOT)
+    return;
+
+  g_debug ("Releasing content at index %d", position);
+
+  // The item saves the dimensions of the widget before dropping it
+  kasasa_content_item_set_widget (item, NULL);
+  slot = adw_carousel_get_nth_page (self->carousel, position);
+  adw_bin_set_child (ADW_BIN (slot), NULL);
+}
+
+// Build the widgets around the center page and release the others; only the
+// center page is kept running
+static void
+update_materialized_contents (KasasaContentContainer *self,
+                              guint                   center)
+{
+  guint n_items = g_list_model_get_n_items (G_LIST_MODEL (self->contents));
+
+  self->materialized_center = center;
+
+  for (guint i = 0; i < n_items; i++)
+    {
+      gboolean neighbor = ABS ((gint) i - (gint) center) <= N_MATERIALIZED_NEIGHBORS;
+      GtkWidget *content = NULL;
+
+      if (neighbor)
+        materialize_item (self, i);
+      else
+        release_item (self, i);
+
+      // Screencasts are never released, so they're trimmed instead
+      content = kasasa_content_item_get_widget (get_item (self, i));
+      if (content == NULL)
+        continue;
+
+      if (i == center)
+        {
+          kasasa_content_resume (KASASA_CONTENT (content));
+          kasasa_memory_budget_touch (kasasa_memory_budget_get_default (),
+                                      KASASA_CONTENT (content));
+        }
+      else if (neighbor)
+        kasasa_content_suspend (KASASA_CONTENT (content));
+      else
+        kasasa_content_trim_memory (KASASA_CONTENT (content),
+                                    CONTENT_TRIM_LEVEL_COMPLETE);
+    }
+}
+
+// Append an item with its widget to the model and the carousel; returns the slot
+static GtkWidget *
+append_content (KasasaContentContainer *self,
+                KasasaContentItem      *item,
+                GtkWidget              *widget)
+{
+  GtkWidget *slot = adw_bin_new ();
+
+  g_list_store_append (self->contents, item);
+  adw_carousel_append (self->carousel, slot);
+
+  adw_bin_set_child (ADW_BIN (slot), widget);
+  kasasa_content_item_set_widget (item, widget);
+
+  // New contents are scrolled to, so they're the most recently viewed
+  kasasa_memory_budget_touch (kasasa_memory_budget_get_default (),
+                              KASASA_CONTENT (widget));
+
+  return slot;
+}
+
+static void
+remove_content (KasasaContentContainer *self,
+                guint                   position)
+{
+  GtkWidget *slot = adw_carousel_get_nth_page (self->carousel, position);
+
+  // The model and the carousel are out of sync until both are updated
+  g_signal_handlers_block_by_func (self->carousel, on_position_changed, self);
+
+  adw_carousel_remove (self->carousel, slot);
+  g_list_store_remove (self->contents, position);
+
+  g_signal_handlers_unblock_by_func (self->carousel, on_position_changed, self);
+}
+/******************************************************************************/
+
+
+
 
 gboolean
 kasasa_content_container_controls_active (KasasaContentContainer *self)
@@ -79,17 +341,16 @@ void
 kasasa_content_container_request_window_resize (KasasaContentContainer *self)
 {
   KasasaWindow *window = NULL;
-  GtkWidget *content = NULL;
   gint new_height, new_width;
 
   g_return_if_fail (KASASA_IS_CONTENT_CONTAINER (self));
 
   window = kasasa_window_get_window_reference (GTK_WIDGET (self));
-  content = get_current_content (self);
 
-  kasasa_content_get_dimensions (KASASA_CONTENT (content),
-                                 &new_height,
-                                 &new_width);
+  // The item knows the dimensions even if its widget was released
+  kasasa_content_item_get_dimensions (get_item (self, get_current_position (self)),
+                                      &new_height,
+                                      &new_width);
 
   kasasa_window_resize_window_scaling (window,
                                        (gdouble) new_height,
@@ -99,28 +360,182 @@ kasasa_content_container_request_window_resize (KasasaContentContainer *self)
 void
 kasasa_content_container_wipe_content (KasasaContentContainer *self)
 {
-  guint n_pages = 0;
+  KasasaWindow *window = NULL;
+  guint n_items = 0;
 
   g_return_if_fail (KASASA_IS_CONTENT_CONTAINER (self));
 
-  n_pages = adw_carousel_get_n_pages (self->carousel);
+  window = kasasa_window_get_window_reference (GTK_WIDGET (self));
+  n_items = g_list_model_get_n_items (G_LIST_MODEL (self->contents));
 
   adw_carousel_set_interactive (self->carousel, FALSE);
 
   // Request finishing content from the last to the first page of the carousel.
   // Pictures are only deleted if the trash_button is toggled
-  for (gint i = n_pages-1; i >= 0; i--)
+  for (gint i = n_items-1; i >= 0; i--)
     {
-      GtkWidget *content = adw_carousel_get_nth_page (self->carousel, i);
+      KasasaContentItem *item = get_item (self, i);
+      GtkWidget *content = kasasa_content_item_get_widget (item);
 
       // Finish the content (KasasaSCreenshot needs a reference to the parent
       // window)...
-      kasasa_content_finish (KASASA_CONTENT (content));
+      if (content != NULL)
+        {
+          kasasa_content_finish (KASASA_CONTENT (content));
+        }
+      else if (kasasa_content_item_get_content_type (item) == CONTENT_TYPE_SCREENSHOT
+               && kasasa_content_item_get_uri (item) != NULL
+               && kasasa_content_item_get_region (item) == NULL
+               && kasasa_window_get_trash_button_active (window))
+        {
+          // Released screenshots are trashed without being loaded again
+          g_autoptr (GFile) file =
+            g_file_new_for_uri (kasasa_content_item_get_uri (item));
+
+          kasasa_screenshot_trash_file (file);
+        }
+
+      // Regions share the file of their capture
+      release_capture (self, item);
+
       // ...then remove it from the carousel
-      adw_carousel_remove (self->carousel, content);
+      remove_content (self, i);
+    }
+}
+
+/*
+ * Release as much as possible while the contents aren't visible (e.g. the window
+ * is miniaturized): screenshots keep only their encoded image, and screencasts
+ * are throttled
+ */
+void
+kasasa_content_container_trim_contents (KasasaContentContainer *self)
+{
+  guint n_items = 0;
+
+  g_return_if_fail (KASASA_IS_CONTENT_CONTAINER (self));
+
+  n_items = g_list_model_get_n_items (G_LIST_MODEL (self->contents));
+
+  for (guint i = 0; i < n_items; i++)
+    {
+      GtkWidget *content = kasasa_content_item_get_widget (get_item (self, i));
+
+      if (KASASA_IS_SCREENCAST (content))
+        {
+          kasasa_screencast_set_max_frame_rate (KASASA_SCREENCAST (content),
+                                                MINIATURIZED_FRAME_RATE);
+          kasasa_content_trim_memory (KASASA_CONTENT (content),
+                                      CONTENT_TRIM_LEVEL_MODERATE);
+        }
+      else if (content != NULL)
+        {
+          kasasa_content_trim_memory (KASASA_CONTENT (content),
+                                      CONTENT_TRIM_LEVEL_COMPLETE);
+        }
+    }
+}
+
+// Undo kasasa_content_container_trim_contents (); images are decoded in a thread
+void
+kasasa_content_container_restore_contents (KasasaContentContainer *self)
+{
+  guint n_items = 0;
+  guint center;
+
+  g_return_if_fail (KASASA_IS_CONTENT_CONTAINER (self));
+
+  n_items = g_list_model_get_n_items (G_LIST_MODEL (self->contents));
+  center = get_current_position (self);
+
+  for (guint i = 0; i < n_items; i++)
+    {
+      GtkWidget *content = kasasa_content_item_get_widget (get_item (self, i));
+
+      if (KASASA_IS_SCREENSHOT (content))
+        {
+          kasasa_screenshot_prefetch (KASASA_SCREENSHOT (content));
+        }
+      else if (KASASA_IS_SCREENCAST (content))
+        {
+          kasasa_screencast_stop_thumbnail (KASASA_SCREENCAST (content));
+          kasasa_screencast_set_max_frame_rate (KASASA_SCREENCAST (content), 0);
+          if (i == center)
+            kasasa_content_resume (KASASA_CONTENT (content));
+        }
+
+      if (content != NULL && i == center)
+        kasasa_memory_budget_touch (kasasa_memory_budget_get_default (),
+                                    KASASA_CONTENT (content));
     }
 }
 
+// Returns a texture of the current content whose smaller side has 'size' pixels,
+// or NULL if the content isn't on the screen
+GdkTexture *
+kasasa_content_container_get_thumbnail (KasasaContentContainer *self,
+                                        gint                    size)
+{
+  GtkWidget *content = NULL;
+  GskRenderer *renderer = NULL;
+  g_autoptr (GdkPaintable) paintable = NULL;
+  g_autoptr (GskRenderNode) node = NULL;
+  GtkSnapshot *snapshot = NULL;
+  gdouble width, height, scale;
+
+  g_return_val_if_fail (KASASA_IS_CONTENT_CONTAINER (self), NULL);
+
+  if (g_list_model_get_n_items (G_LIST_MODEL (self->contents)) == 0)
+    return NULL;
+
+  content = get_current_content (self);
+  if (content == NULL || !gtk_widget_get_mapped (content))
+    return NULL;
+
+  renderer = gtk_native_get_renderer (gtk_widget_get_native (content));
+  if (renderer == NULL)
+    return NULL;
+
+  paintable = gtk_widget_paintable_new (content);
+  width = gtk_widget_get_width (content);
+  height = gtk_widget_get_height (content);
+  if (width <= 0 || height <= 0)
+    return NULL;
+
+  scale = MAX (size / width, size / height);
+  width *= scale;
+  height *= scale;
+
+  snapshot = gtk_snapshot_new ();
+  gdk_paintable_snapshot (paintable, GDK_SNAPSHOT (snapshot), width, height);
+  node = gtk_snapshot_free_to_node (snapshot);
+  if (node == NULL)
+    return NULL;
+
+  return gsk_renderer_render_texture (renderer, node,
+                                      &GRAPHENE_RECT_INIT (0, 0, width, height));
+}
+
+// Returns a live, downscaled rendition of the current content if it's a running
+// screencast, or NULL; it's shown until the contents are restored
+GdkPaintable *
+kasasa_content_container_get_live_thumbnail (KasasaContentContainer *self,
+                                             gint                    size)
+{
+  GtkWidget *content = NULL;
+
+  g_return_val_if_fail (KASASA_IS_CONTENT_CONTAINER (self), NULL);
+
+  if (g_list_model_get_n_items (G_LIST_MODEL (self->contents)) == 0)
+    return NULL;
+
+  content = get_current_content (self);
+  if (!KASASA_IS_SCREENCAST (content))
+    return NULL;
+
+  return kasasa_screencast_start_thumbnail (KASASA_SCREENCAST (content), size);
+}
+
 void
 kasasa_content_container_carousel_set_interactive (KasasaContentContainer *self,
                                                    gboolean interactive)
@@ -132,8 +547,12 @@ kasasa_content_container_carousel_set_interactive (KasasaContentContainer *self,
 static void
 kasasa_content_container_update_toolbar_sensibility (KasasaContentContainer *self)
 {
+  KasasaContentItem *current_item = NULL;
+
   g_return_if_fail (KASASA_IS_CONTENT_CONTAINER (self));
 
+  current_item = get_item (self, get_current_position (self));
+
   // Restore the whole overlay sesibility...
   gtk_widget_set_sensitive (GTK_WIDGET (self->toolbar_overlay), TRUE);
 
@@ -160,7 +579,34 @@ kasasa_content_container_update_toolbar_sensibility (KasasaContentContainer *sel
     gtk_widget_set_sensitive (GTK_WIDGET (self->remove_content_button),
                               FALSE);
 
-  gtk_widget_set_sensitive (GTK_WIDGET (self->retake_screenshot_button), TRUE);
+  // Screencasts can't be retaken
+  gtk_widget_set_sensitive (GTK_WIDGET (self->retake_screenshot_button),
+                            current_item != NULL
+                            && kasasa_content_item_get_content_type (current_item) == CONTENT_TYPE_SCREENSHOT);
+}
+
+// The live modes only apply to a screencast showing frames
+static void
+update_screencast_buttons (KasasaContentContainer *self,
+                           GtkWidget              *content)
+{
+  gboolean running = KASASA_IS_SCREENCAST (content)
+                     && kasasa_screencast_is_running (KASASA_SCREENCAST (content));
+
+  gtk_widget_set_sensitive (GTK_WIDGET (self->freeze_frame_button), running);
+  gtk_widget_set_sensitive (GTK_WIDGET (self->watch_button), running);
+  gtk_widget_set_sensitive (GTK_WIDGET (self->refresh_button), running);
+}
+
+// The window was revealed again before being hidden
+static void
+on_hide_window_cancelled (gpointer user_data)
+{
+  KasasaContentContainer *self = KASASA_CONTENT_CONTAINER (user_data);
+  KasasaWindow *window = kasasa_window_get_window_reference (GTK_WIDGET (self));
+
+  kasasa_content_container_update_toolbar_sensibility (self);
+  kasasa_window_block_miniaturization (window, FALSE);
 }
 
 static void
@@ -179,19 +625,24 @@ append_screenshot (KasasaContentContainer *self,
                    const gchar            *uri)
 {
   KasasaScreenshot *new_screenshot = NULL;
-  guint n_pages = adw_carousel_get_n_pages (self->carousel);
-  g_debug ("Carousel number of pages: %d", n_pages);
+  g_autoptr (KasasaContentItem) item = NULL;
+  GtkWidget *slot = NULL;
+  guint n_items = g_list_model_get_n_items (G_LIST_MODEL (self->contents));
+  g_debug ("Carousel number of pages: %d", n_items);
 
-  if (n_pages >= MAX_N_CONTENTS)
+  if (n_items >= MAX_N_CONTENTS)
     {
       g_warning ("Max number of contents reached");
       return;
     }
 
+  item = kasasa_content_item_new (CONTENT_TYPE_SCREENSHOT);
+  kasasa_content_item_set_uri (item, uri);
+
   new_screenshot = kasasa_screenshot_new ();
-  adw_carousel_append (self->carousel, GTK_WIDGET (new_screenshot));
+  slot = append_content (self, item, GTK_WIDGET (new_screenshot));
   kasasa_screenshot_load_screenshot (new_screenshot, uri);
-  adw_carousel_scroll_to (self->carousel, GTK_WIDGET (new_screenshot), TRUE);
+  adw_carousel_scroll_to (self->carousel, slot, TRUE);
 }
 
 static void
@@ -207,7 +658,7 @@ handle_taken_screenshot (GObject      *object,
 
   window = kasasa_window_get_window_reference (GTK_WIDGET (self));
   kasasa_window_hide_window (window, FALSE,
-                             NULL, NULL);
+                             NULL, NULL, NULL);
 
   uri =  xdp_portal_take_screenshot_finish (
     self->portal,
@@ -244,7 +695,12 @@ handle_taken_screenshot (GObject      *object,
       KasasaScreenshot *screenshot =
         KASASA_SCREENSHOT (get_current_content (self));
 
+      KasasaContentItem *item = get_item (self, get_current_position (self));
+
+      release_capture (self, item);
       kasasa_screenshot_load_screenshot (screenshot, uri);
+      kasasa_content_item_set_uri (item, uri);
+      kasasa_content_item_set_region (item, NULL);
     }
   else
     {
@@ -275,6 +731,74 @@ on_screencast_new_dimension (KasasaScreencast *screencast,
                                          (gdouble) new_width);
 }
 
+// A watched screencast changed: bring the window to the user's attention
+static void
+on_screencast_changed (KasasaScreencast *screencast,
+                       gpointer          user_data)
+{
+  KasasaContentContainer *self = KASASA_CONTENT_CONTAINER (user_data);
+  KasasaWindow *window = kasasa_window_get_window_reference (GTK_WIDGET (self));
+  g_autoptr (GNotification) notification = NULL;
+
+  if (!kasasa_window_is_miniaturized (window))
+    {
+      kasasa_window_change_opacity (window, OPACITY_INCREASE);
+      return;
+    }
+
+  kasasa_window_flash_miniature (window);
+
+  // The same id is used, so a single notification is shown
+  notification = g_notification_new (_("Screencast changed"));
+  g_notification_set_body (notification, _("A watched screencast has changed"));
+  g_application_send_notification (g_application_get_default (),
+                                   "screencast-changed",
+                                   notification);
+}
+
+static void
+on_stream_reconnected (GObject      *source_object,
+                       GAsyncResult *res,
+                       gpointer      user_data)
+{
+  g_autoptr (KasasaContentContainer) self = KASASA_CONTENT_CONTAINER (user_data);
+  g_autoptr (GError) error = NULL;
+
+  // On failure, the screencasts of the stream are removed as on end-of-stream
+  if (!kasasa_stream_reconnect_finish (KASASA_STREAM (source_object), res, &error))
+    g_debug ("Reconnection failed: %s", error->message);
+
+  // The window was closed while the session dialog was shown
+  if (self->contents == NULL)
+    return;
+
+  kasasa_content_container_update_toolbar_sensibility (self);
+  update_screencast_buttons (self,
+                             kasasa_content_item_get_widget (get_item (self, get_current_position (self))));
+}
+
+static void
+on_screencast_reconnect (KasasaScreencast *screencast,
+                         gpointer          user_data)
+{
+  KasasaContentContainer *self = KASASA_CONTENT_CONTAINER (user_data);
+  KasasaStream *stream = kasasa_screencast_get_stream (screencast);
+  GtkWindow *window = NULL;
+
+  if (stream == NULL)
+    return;
+
+  // The stream owns its parent, as the container may be gone before the
+  // session dialog is done
+  window = GTK_WINDOW (kasasa_window_get_window_reference (GTK_WIDGET (self)));
+
+  kasasa_stream_reconnect_async (stream,
+                                 self->portal,
+                                 xdp_parent_new_gtk (window),
+                                 on_stream_reconnected,
+                                 g_object_ref (self));
+}
+
 static void
 on_screencast_eos (KasasaScreencast *screencast,
                    gpointer          user_data)
@@ -284,6 +808,10 @@ on_screencast_eos (KasasaScreencast *screencast,
 
   gboolean miniaturized = kasasa_window_is_miniaturized (window);
   guint n_pages = adw_carousel_get_n_pages (self->carousel);
+  guint position;
+
+  if (!find_item (self, GTK_WIDGET (screencast), &position))
+    return;
 
   adw_carousel_set_interactive (self->carousel, FALSE);
   kasasa_content_finish (KASASA_CONTENT (screencast));
@@ -299,24 +827,20 @@ on_screencast_eos (KasasaScreencast *screencast,
       // the window will present a no content view after unminiaturized
     }
   else if (n_pages >= 2
-           && get_current_content (self) == GTK_WIDGET (screencast))
+           && get_current_position (self) == position)
     {
       // scroll to the neighbor content
-      GtkWidget *neighbor_content = NULL;
-      guint neighbor_idx;
+      GtkWidget *neighbor_slot = NULL;
+      guint neighbor_idx = (position == 0) ? position + 1 : position - 1;
 
       kasasa_window_miniaturize_window (window, FALSE);
 
+      neighbor_slot = adw_carousel_get_nth_page (self->carousel, neighbor_idx);
 
-      for (guint i = 0; i < n_pages; i++)
-        if (adw_carousel_get_nth_page (self->carousel, i) == GTK_WIDGET (screencast))
-          neighbor_idx = ((gint) i - 1 < 0) ? i + 1 : i - 1;
-
-      neighbor_content = adw_carousel_get_nth_page (self->carousel,
-                                                    neighbor_idx);
-
-      adw_carousel_remove (self->carousel, GTK_WIDGET (screencast));
-      adw_carousel_scroll_to (self->carousel, neighbor_content, TRUE);
+      remove_content (self, position);
+      // The neighbor index is shifted if the removed content came before it
+      update_materialized_contents (self, (position == 0) ? 0 : neighbor_idx);
+      adw_carousel_scroll_to (self->carousel, neighbor_slot, TRUE);
 
       if (miniaturized)
         kasasa_window_miniaturize_window (window, TRUE);
@@ -324,7 +848,8 @@ on_screencast_eos (KasasaScreencast *screencast,
   else
     {
       // silently remove the content
-      adw_carousel_remove (self->carousel, GTK_WIDGET (screencast));
+      remove_content (self, position);
+      update_materialized_contents (self, get_current_position (self));
     }
 
   adw_carousel_set_interactive (self->carousel, TRUE);
@@ -343,7 +868,6 @@ on_first_screenshot_taken (GObject      *object,
 {
   KasasaContentContainer *self = KASASA_CONTENT_CONTAINER (user_data);
   KasasaWindow *window = kasasa_window_get_window_reference (GTK_WIDGET (self));
-  g_autoptr (GSettings) settings = g_settings_new ("io.github.kelvinnovais.Kasasa");
   g_autoptr (GError) error = NULL;
   g_autofree gchar *uri = NULL;
   g_autofree gchar *error_message = NULL;
@@ -373,7 +897,7 @@ on_first_screenshot_taken (GObject      *object,
   gtk_widget_set_visible (GTK_WIDGET (window), TRUE);
 
   // Enable auto discard window timer
-  if (g_settings_get_boolean (settings, "auto-discard-window"))
+  if (kasasa_settings_get_values (self->settings)->auto_discard_window)
     kasasa_window_auto_discard_window (window);
 
   kasasa_window_miniaturize_window (window, TRUE);
@@ -458,7 +982,8 @@ take_screenshot (GtkButton *button,
   kasasa_window_block_miniaturization (window, TRUE);
 
   kasasa_window_hide_window (window, TRUE,
-                             take_screenshot_cb, self);
+                             take_screenshot_cb,
+                             on_hide_window_cancelled, self);
 }
 
 static void
@@ -467,15 +992,14 @@ take_delayed_screenshot (GtkButton *button,
 {
   KasasaContentContainer *self = KASASA_CONTENT_CONTAINER (user_data);
   KasasaWindow *window = kasasa_window_get_window_reference (GTK_WIDGET (self));
-  guint interval = g_settings_get_uint (self->settings,
-                                        "screenshot-delay");
+  guint interval = kasasa_settings_get_values (self->settings)->screenshot_delay;
 
   gtk_popover_popdown (self->more_actions_popover);
   gtk_widget_set_sensitive (GTK_WIDGET (self->toolbar_overlay), FALSE);
 
   kasasa_window_block_miniaturization (window, TRUE);
   kasasa_window_hide_window (window, TRUE,
-                             NULL, NULL);
+                             NULL, NULL, NULL);
 
   g_timeout_add_seconds_once (interval, take_screenshot_cb, self);
 }
@@ -484,61 +1008,296 @@ take_delayed_screenshot (GtkButton *button,
 
 
 
-/***************************** RETAKE SCREENSHOT ******************************/
-// retake_screenshot -> retake_screenshot_cb -> on_screenshot_retaken
+/*************************** ADD MULTIPLE REGIONS *****************************/
+// take_regions_screenshot -> take_regions_screenshot_cb -> on_regions_screenshot_taken -> on_regions_selected
 static void
-on_screenshot_retaken (GObject      *object,
-                       GAsyncResult *res,
-                       gpointer      user_data)
+append_region (KasasaContentContainer *self,
+               GdkTexture             *texture,
+               const graphene_rect_t  *region)
+{
+  g_autoptr (KasasaContentItem) item = NULL;
+  g_autoptr (KasasaTextureRegion) texture_region = NULL;
+  KasasaScreenshot *screenshot = NULL;
+
+  if (g_list_model_get_n_items (G_LIST_MODEL (self->contents)) >= MAX_N_CONTENTS)
+    {
+      g_warning ("Max number of contents reached");
+      return;
+    }
+
+  // All the regions share the texture
+  texture_region = kasasa_texture_region_new (texture, region);
+
+  item = kasasa_content_item_new (CONTENT_TYPE_SCREENSHOT);
+  kasasa_content_item_set_uri (item, self->regions_uri);
+  kasasa_content_item_set_region (item, texture_region);
+
+  screenshot = kasasa_screenshot_new ();
+  append_content (self, item, GTK_WIDGET (screenshot));
+  kasasa_screenshot_show_region (screenshot, texture_region);
+}
+
+static void
+on_regions_selected (KasasaRegionSelector *selector,
+                     GArray               *regions,
+                     gpointer              user_data)
 {
   KasasaContentContainer *self = KASASA_CONTENT_CONTAINER (user_data);
   KasasaWindow *window = kasasa_window_get_window_reference (GTK_WIDGET (self));
+  GdkTexture *texture = kasasa_region_selector_get_texture (selector);
+  guint n_pages;
 
-  kasasa_window_block_miniaturization (window, FALSE);
+  for (guint i = 0; i < regions->len; i++)
+    append_region (self, texture, &g_array_index (regions, graphene_rect_t, i));
 
-  handle_taken_screenshot (object, res, user_data, TRUE);
+  // Nothing was pinned (e.g. the selection was cancelled): the capture was only
+  // taken for the selector
+  if (!is_capture_shared (self, self->regions_uri, NULL))
+    {
+      g_autoptr (GFile) file = g_file_new_for_uri (self->regions_uri);
 
-  kasasa_content_container_update_toolbar_sensibility (self);
+      kasasa_screenshot_trash_file (file);
+    }
 
-  // Enable carousel again
-  adw_carousel_set_interactive (self->carousel, TRUE);
+  g_clear_pointer (&self->regions_uri, g_free);
+
+  // Show the last pinned region; changing the page resizes the window
+  n_pages = adw_carousel_get_n_pages (self->carousel);
+  if (regions->len > 0 && n_pages > 0)
+    adw_carousel_scroll_to (self->carousel,
+                            adw_carousel_get_nth_page (self->carousel, n_pages - 1),
+                            TRUE);
+
+  kasasa_window_hide_window (window, FALSE,
+                             NULL, NULL, NULL);
+  kasasa_content_container_update_toolbar_sensibility (self);
+  kasasa_window_block_miniaturization (window, FALSE);
 }
 
 static void
-retake_screenshot_cb (gpointer user_data)
+on_regions_screenshot_taken (GObject      *object,
+                             GAsyncResult *res,
+                             gpointer      user_data)
 {
   KasasaContentContainer *self = KASASA_CONTENT_CONTAINER (user_data);
+  KasasaWindow *window = kasasa_window_get_window_reference (GTK_WIDGET (self));
+  KasasaRegionSelector *selector = NULL;
+  g_autoptr (GError) error = NULL;
+  g_autoptr (GFile) file = NULL;
+  g_autoptr (GdkTexture) texture = NULL;
+  g_autofree gchar *uri = NULL;
 
-  // Avoid changing the carousel page
-  adw_carousel_set_interactive (self->carousel, FALSE);
+  uri = xdp_portal_take_screenshot_finish (self->portal, res, &error);
+
+  // Decode the capture once; every region is a view of this texture
+  if (error == NULL && uri != NULL)
+    {
+      file = g_file_new_for_uri (uri);
+      texture = gdk_texture_new_from_file (file, &error);
+    }
+
+  if (error != NULL || texture == NULL)
+    {
+      const gchar *error_message = (error != NULL) ? error->message : _("Couldn't load the screenshot");
+      AdwToast *toast = adw_toast_new_format (_("Error: %s"), error_message);
+      adw_toast_set_action_target_value (toast, g_variant_new_string (error_message));
+      adw_toast_set_button_label (toast, _("Copy"));
+      adw_toast_set_action_name (toast, "toast.copy_error");
+      adw_toast_overlay_add_toast (self->toast_overlay, toast);
+      g_warning ("%s", error_message);
+
+      kasasa_window_hide_window (window, FALSE,
+                                 NULL, NULL, NULL);
+      kasasa_content_container_update_toolbar_sensibility (self);
+      kasasa_window_block_miniaturization (window, FALSE);
+      return;
+    }
+
+  g_free (self->regions_uri);
+  self->regions_uri = g_steal_pointer (&uri);
+
+  selector = kasasa_region_selector_new (texture);
+  gtk_window_set_transient_for (GTK_WINDOW (selector), GTK_WINDOW (window));
+  g_signal_connect_object (selector, "regions-selected",
+                           G_CALLBACK (on_regions_selected), self, 0);
+  gtk_window_fullscreen (GTK_WINDOW (selector));
+  gtk_window_present (GTK_WINDOW (selector));
+}
+
+static void
+take_regions_screenshot_cb (gpointer user_data)
+{
+  KasasaContentContainer *self = KASASA_CONTENT_CONTAINER (user_data);
 
+  // A single non interactive capture; the regions are selected in the app
   xdp_portal_take_screenshot (
     self->portal,
     NULL,
-    XDP_SCREENSHOT_FLAG_INTERACTIVE,
+    XDP_SCREENSHOT_FLAG_NONE,
     NULL,
-    on_screenshot_retaken,
+    on_regions_screenshot_taken,
     self
   );
 }
 
 static void
-retake_screenshot (GtkButton *button, gpointer user_data)
+take_regions_screenshot (GtkButton *button,
+                         gpointer   user_data)
 {
-  KasasaContentContainer *self = NULL;
-  KasasaWindow *window = NULL;
-
+  KasasaContentContainer *self = KASASA_CONTENT_CONTAINER (user_data);
+  KasasaWindow *window = kasasa_window_get_window_reference (GTK_WIDGET (self));
+
+  gtk_popover_popdown (self->more_actions_popover);
+  gtk_widget_set_sensitive (GTK_WIDGET (self->toolbar_overlay), FALSE);
+
+  kasasa_window_block_miniaturization (window, TRUE);
+
+  kasasa_window_hide_window (window, TRUE,
+                             take_regions_screenshot_cb,
+                             on_hide_window_cancelled, self);
+}
+/******************************************************************************/
+
+
+
+
+/***************************** RETAKE SCREENSHOT ******************************/
+// retake_screenshot -> retake_screenshot_cb -> on_screenshot_retaken
+// retake_screenshot -> on_frame_grabbed (fast retake)
+static void
+on_frame_grabbed (GObject      *object,
+                  GAsyncResult *res,
+                  gpointer      user_data)
+{
+  g_autoptr (KasasaContentContainer) self = KASASA_CONTENT_CONTAINER (user_data);
+  g_autoptr (KasasaTextureRegion) region = NULL;
+  g_autoptr (GError) error = NULL;
+  KasasaWindow *window = kasasa_window_get_window_reference (GTK_WIDGET (self));
+  KasasaContentItem *item = NULL;
+  GtkWidget *content = NULL;
+  guint position;
+
+  kasasa_window_block_miniaturization (window, FALSE);
+  kasasa_content_container_update_toolbar_sensibility (self);
+  adw_carousel_set_interactive (self->carousel, TRUE);
+
+  region = kasasa_frame_source_grab_finish (KASASA_FRAME_SOURCE (object), res, &error);
+  if (error != NULL)
+    {
+      AdwToast *toast = adw_toast_new_format (_("Error: %s"), error->message);
+      adw_toast_set_action_target_value (toast, g_variant_new_string (error->message));
+      adw_toast_set_button_label (toast, _("Copy"));
+      adw_toast_set_action_name (toast, "toast.copy_error");
+      adw_toast_overlay_add_toast (self->toast_overlay, toast);
+      g_warning ("%s", error->message);
+      return;
+    }
+
+  // The page may have been removed in the meantime
+  position = get_current_position (self);
+  item = get_item (self, position);
+  if (item == NULL
+      || kasasa_content_item_get_frame_source (item) != KASASA_FRAME_SOURCE (object))
+    return;
+
+  content = kasasa_content_item_get_widget (item);
+  if (!KASASA_IS_SCREENSHOT (content))
+    return;
+
+  // Replace with the new frame; the previous image is trashed if requested
+  kasasa_content_finish (KASASA_CONTENT (content));
+  release_capture (self, item);
+  kasasa_screenshot_show_region (KASASA_SCREENSHOT (content), region);
+  kasasa_content_item_set_region (item, region);
+  kasasa_content_item_set_uri (item, NULL);
+
+  kasasa_content_container_request_window_resize (self);
+}
+
+static void
+on_screenshot_retaken (GObject      *object,
+                       GAsyncResult *res,
+                       gpointer      user_data)
+{
+  KasasaContentContainer *self = KASASA_CONTENT_CONTAINER (user_data);
+  KasasaWindow *window = kasasa_window_get_window_reference (GTK_WIDGET (self));
+
+  kasasa_window_block_miniaturization (window, FALSE);
+
+  handle_taken_screenshot (object, res, user_data, TRUE);
+
+  kasasa_content_container_update_toolbar_sensibility (self);
+
+  // Enable carousel again
+  adw_carousel_set_interactive (self->carousel, TRUE);
+}
+
+static void
+retake_screenshot_cb (gpointer user_data)
+{
+  KasasaContentContainer *self = KASASA_CONTENT_CONTAINER (user_data);
+
+  // Avoid changing the carousel page
+  adw_carousel_set_interactive (self->carousel, FALSE);
+
+  xdp_portal_take_screenshot (
+    self->portal,
+    NULL,
+    XDP_SCREENSHOT_FLAG_INTERACTIVE,
+    NULL,
+    on_screenshot_retaken,
+    self
+  );
+}
+
+static void
+retake_screenshot (GtkButton *button, gpointer user_data)
+{
+  KasasaContentContainer *self = NULL;
+  KasasaWindow *window = NULL;
+  KasasaContentItem *item = NULL;
+
   g_return_if_fail (KASASA_IS_CONTENT_CONTAINER (user_data));
 
   self = KASASA_CONTENT_CONTAINER (user_data);
   window = kasasa_window_get_window_reference (GTK_WIDGET (self));
+  item = get_item (self, get_current_position (self));
+
+  // Screencasts and their frames can't be retaken
+  if (item == NULL
+      || kasasa_content_item_get_content_type (item) != CONTENT_TYPE_SCREENSHOT)
+    return;
 
   gtk_widget_set_sensitive (GTK_WIDGET (self->toolbar_overlay), FALSE);
 
   kasasa_window_block_miniaturization (window, TRUE);
 
+  // Fast retake: grab a frame of a window stream, without hiding the window
+  if (kasasa_settings_get_values (self->settings)->fast_retake)
+    {
+      KasasaFrameSource *frame_source = kasasa_content_item_get_frame_source (item);
+
+      if (frame_source == NULL)
+        {
+          frame_source = kasasa_frame_source_new (self->portal);
+          kasasa_content_item_set_frame_source (item, frame_source);
+          g_object_unref (frame_source);
+        }
+
+      // Avoid changing the carousel page
+      adw_carousel_set_interactive (self->carousel, FALSE);
+
+      // The frame source owns its parent, as its session outlives this grab
+      kasasa_frame_source_grab_async (frame_source,
+                                      xdp_parent_new_gtk (GTK_WINDOW (window)),
+                                      on_frame_grabbed,
+                                      g_object_ref (self));
+      return;
+    }
+
   kasasa_window_hide_window (window, TRUE,
-                             retake_screenshot_cb, self);
+                             retake_screenshot_cb,
+                             on_hide_window_cancelled, self);
 }
 /******************************************************************************/
 
@@ -547,6 +1306,132 @@ retake_screenshot (GtkButton *button, gpointer user_data)
 
 /********************************* SCREENCAST *********************************/
 // create_screencast_session -> create_screencast_session_cb -> on_screencast_session_started
+// create_screencast_region_session -> ... -> on_screencast_session_started ->
+//   select_screencast_region -> check_region_frame -> on_screencast_regions_selected
+// duplicate_screencast
+static KasasaScreencast *
+append_screencast_for_stream (KasasaContentContainer *self,
+                              KasasaStream           *stream)
+{
+  g_autoptr (KasasaContentItem) item = NULL;
+  KasasaScreencast *screencast = NULL;
+
+  if (g_list_model_get_n_items (G_LIST_MODEL (self->contents)) >= MAX_N_CONTENTS)
+    {
+      g_warning ("Max number of contents reached");
+      return NULL;
+    }
+
+  item = kasasa_content_item_new (CONTENT_TYPE_SCREENCAST);
+  screencast = kasasa_screencast_new ();
+
+  g_signal_connect (screencast, "new-dimension",
+                    G_CALLBACK (on_screencast_new_dimension), self);
+  g_signal_connect (screencast, "eos",
+                    G_CALLBACK (on_screencast_eos), self);
+  g_signal_connect (screencast, "changed",
+                    G_CALLBACK (on_screencast_changed), self);
+  g_signal_connect (screencast, "reconnect",
+                    G_CALLBACK (on_screencast_reconnect), self);
+
+  kasasa_screencast_show_stream (screencast, stream);
+  append_content (self, item, GTK_WIDGET (screencast));
+
+  return screencast;
+}
+
+static void
+on_screencast_regions_selected (KasasaRegionSelector *selector,
+                                GArray               *regions,
+                                gpointer              user_data)
+{
+  KasasaContentContainer *self = KASASA_CONTENT_CONTAINER (user_data);
+  KasasaScreencast *screencast = self->selecting_screencast;
+  KasasaStream *stream = NULL;
+
+  g_clear_weak_pointer (&self->selecting_screencast);
+
+  // If cancelled, the whole window is kept
+  if (screencast == NULL || regions->len == 0)
+    return;
+
+  // The crop of the screencast may have changed while selecting, so the
+  // regions are placed in the whole frame from the origin of the frame shown
+  stream = kasasa_screencast_get_stream (screencast);
+  for (guint i = 0; i < regions->len && stream != NULL; i++)
+    {
+      KasasaScreencast *region_screencast = screencast;
+      graphene_rect_t region;
+
+      graphene_rect_offset_r (&g_array_index (regions, graphene_rect_t, i),
+                              self->region_frame_origin.x,
+                              self->region_frame_origin.y,
+                              &region);
+
+      // Every other region is a new page sharing the stream
+      if (i > 0)
+        region_screencast = append_screencast_for_stream (self, stream);
+
+      if (region_screencast == NULL)
+        break;
+
+      kasasa_screencast_set_region (region_screencast, &region);
+    }
+
+  kasasa_content_container_update_toolbar_sensibility (self);
+  kasasa_content_container_request_window_resize (self);
+}
+
+// Wait for the first frame, then let the user select the region on it
+static gboolean
+check_region_frame (gpointer user_data)
+{
+  KasasaContentContainer *self = KASASA_CONTENT_CONTAINER (user_data);
+  KasasaWindow *window = kasasa_window_get_window_reference (GTK_WIDGET (self));
+  g_autoptr (GdkTexture) texture = NULL;
+  KasasaRegionSelector *selector = NULL;
+
+  if (self->selecting_screencast != NULL)
+    texture = kasasa_screencast_get_frame (self->selecting_screencast,
+                                           &self->region_frame_origin);
+
+  if (texture == NULL)
+    {
+      if (self->selecting_screencast != NULL
+          && ++self->n_region_frame_checks < REGION_FRAME_N_CHECKS)
+        return G_SOURCE_CONTINUE;
+
+      g_warning ("No frame received, showing the whole screencast");
+      g_clear_weak_pointer (&self->selecting_screencast);
+      self->region_frame_source = 0;
+      return G_SOURCE_REMOVE;
+    }
+
+  selector = kasasa_region_selector_new (texture);
+  gtk_window_set_transient_for (GTK_WINDOW (selector), GTK_WINDOW (window));
+  g_signal_connect_object (selector, "regions-selected",
+                           G_CALLBACK (on_screencast_regions_selected), self, 0);
+  gtk_window_fullscreen (GTK_WINDOW (selector));
+  gtk_window_present (GTK_WINDOW (selector));
+
+  self->region_frame_source = 0;
+  return G_SOURCE_REMOVE;
+}
+
+static void
+select_screencast_region (KasasaContentContainer *self,
+                          KasasaScreencast       *screencast)
+{
+  self->select_screencast_region = FALSE;
+
+  g_clear_handle_id (&self->region_frame_source, g_source_remove);
+  g_set_weak_pointer (&self->selecting_screencast, screencast);
+  self->n_region_frame_checks = 0;
+  self->region_frame_source = g_timeout_add (REGION_FRAME_CHECK_INTERVAL,
+                                             check_region_frame,
+                                             self);
+}
+
 static void
 on_screencast_session_started (GObject      *source_object,
                                GAsyncResult *res,
@@ -559,6 +1444,8 @@ on_screencast_session_started (GObject      *source_object,
   g_autoptr (GVariant) streams = NULL;
   g_autoptr (GVariant) stream = NULL;
   KasasaScreencast *screencast = NULL;
+  g_autoptr (KasasaContentItem) item = NULL;
+  GtkWidget *slot = NULL;
   XdpSession *session = NULL;
   gboolean success;
 
@@ -588,17 +1475,25 @@ on_screencast_session_started (GObject      *source_object,
 
   g_debug ("Streams: %s", g_variant_print (streams, TRUE));
 
+  item = kasasa_content_item_new (CONTENT_TYPE_SCREENCAST);
   screencast = kasasa_screencast_new ();
 
   g_signal_connect (screencast, "new-dimension",
                     G_CALLBACK (on_screencast_new_dimension), self);
   g_signal_connect (screencast, "eos",
                     G_CALLBACK (on_screencast_eos), self);
+  g_signal_connect (screencast, "changed",
+                    G_CALLBACK (on_screencast_changed), self);
+  g_signal_connect (screencast, "reconnect",
+                    G_CALLBACK (on_screencast_reconnect), self);
 
   kasasa_screencast_show (screencast, session, fd, node_id);
-  adw_carousel_append (self->carousel, GTK_WIDGET (screencast));
-  adw_carousel_scroll_to (self->carousel, GTK_WIDGET (screencast), TRUE);
+  slot = append_content (self, item, GTK_WIDGET (screencast));
+  adw_carousel_scroll_to (self->carousel, slot, TRUE);
   kasasa_content_container_update_toolbar_sensibility (self);
+
+  if (self->select_screencast_region)
+    select_screencast_region (self, screencast);
 }
 
 static void
@@ -633,10 +1528,9 @@ create_screencast_session_cb (GObject      *source_object,
 }
 
 static void
-create_screencast_session (GtkButton *button,
-                           gpointer   user_data)
+start_screencast_session (KasasaContentContainer *self,
+                          XdpOutputType           outputs)
 {
-  KasasaContentContainer *self = KASASA_CONTENT_CONTAINER (user_data);
   KasasaWindow *window = kasasa_window_get_window_reference (GTK_WIDGET (self));
 
   gtk_popover_popdown (self->more_actions_popover);
@@ -644,7 +1538,7 @@ create_screencast_session (GtkButton *button,
   kasasa_window_block_miniaturization (window, TRUE);
 
   xdp_portal_create_screencast_session (self->portal,
-                                        XDP_OUTPUT_WINDOW,
+                                        outputs,
                                         XDP_SCREENCAST_FLAG_NONE,
                                         XDP_CURSOR_MODE_HIDDEN,
                                         XDP_PERSIST_MODE_TRANSIENT,
@@ -653,6 +1547,60 @@ create_screencast_session (GtkButton *button,
                                         create_screencast_session_cb,
                                         self);
 }
+
+static void
+create_screencast_session (GtkButton *button,
+                           gpointer   user_data)
+{
+  KasasaContentContainer *self = KASASA_CONTENT_CONTAINER (user_data);
+
+  self->select_screencast_region = FALSE;
+  start_screencast_session (self, XDP_OUTPUT_WINDOW);
+}
+
+// A region of a window or of a monitor is selected after the session starts
+static void
+create_screencast_region_session (GtkButton *button,
+                                  gpointer   user_data)
+{
+  KasasaContentContainer *self = KASASA_CONTENT_CONTAINER (user_data);
+
+  self->select_screencast_region = TRUE;
+  start_screencast_session (self, XDP_OUTPUT_WINDOW | XDP_OUTPUT_MONITOR);
+}
+
+// Show the stream of the current screencast in a new page; no new session nor
+// pipeline is created
+static void
+duplicate_screencast (GtkButton *button,
+                      gpointer   user_data)
+{
+  KasasaContentContainer *self = KASASA_CONTENT_CONTAINER (user_data);
+  KasasaScreencast *screencast = NULL;
+  KasasaStream *stream = NULL;
+  GtkWidget *content = NULL;
+  guint n_pages;
+
+  gtk_popover_popdown (self->more_actions_popover);
+
+  content = get_current_content (self);
+
+  g_return_if_fail (KASASA_IS_SCREENCAST (content));
+
+  stream = kasasa_screencast_get_stream (KASASA_SCREENCAST (content));
+  if (stream == NULL)
+    return;
+
+  screencast = append_screencast_for_stream (self, stream);
+  if (screencast == NULL)
+    return;
+
+  n_pages = adw_carousel_get_n_pages (self->carousel);
+  adw_carousel_scroll_to (self->carousel,
+                          adw_carousel_get_nth_page (self->carousel, n_pages - 1),
+                          TRUE);
+  kasasa_content_container_update_toolbar_sensibility (self);
+}
 /******************************************************************************/
 
 
@@ -668,13 +1616,30 @@ kasasa_content_container_request_first_screenshot (KasasaContentContainer *self)
 static GtkWidget *
 get_current_content (KasasaContentContainer *self)
 {
-  guint position = (guint) adw_carousel_get_position (self->carousel);
+  guint position = get_current_position (self);
+  KasasaContentItem *item = get_item (self, position);
 
-  g_return_val_if_fail ((position < MAX_N_CONTENTS), NULL);
+  g_return_val_if_fail ((item != NULL), NULL);
 
   g_debug ("Carousel current position: %d", position);
 
-  return adw_carousel_get_nth_page (self->carousel, position);
+  // The current page is materialized whenever the position changes
+  return kasasa_content_item_get_widget (item);
+}
+
+static void
+on_position_changed (GObject    *object,
+                     GParamSpec *pspec,
+                     gpointer    user_data)
+{
+  KasasaContentContainer *self = KASASA_CONTENT_CONTAINER (user_data);
+  guint position = get_current_position (self);
+
+  // Materialize pages as they come into view while swiping; the position is
+  // notified on every frame of the animation, but the center rarely changes
+  if (position != self->materialized_center
+      && g_list_model_get_n_items (G_LIST_MODEL (self->contents)) > 0)
+    update_materialized_contents (self, position);
 }
 
 static void
@@ -701,6 +1666,46 @@ on_mouse_leave_controls (GtkEventControllerMotion *event_controller_motion,
   kasasa_window_change_opacity (window, OPACITY_DECREASE);
 }
 
+static void
+on_watch_button_toggled (GtkToggleButton *button,
+                         gpointer         user_data)
+{
+  KasasaContentContainer *self = KASASA_CONTENT_CONTAINER (user_data);
+  GtkWidget *content = get_current_content (self);
+
+  if (!KASASA_IS_SCREENCAST (content))
+    return;
+
+  kasasa_screencast_set_watching (KASASA_SCREENCAST (content),
+                                  gtk_toggle_button_get_active (button));
+}
+
+static void
+on_refresh_interval_changed (GtkSpinButton *spin_button,
+                             gpointer       user_data)
+{
+  KasasaContentContainer *self = KASASA_CONTENT_CONTAINER (user_data);
+  GtkWidget *content = get_current_content (self);
+
+  if (!KASASA_IS_SCREENCAST (content))
+    return;
+
+  kasasa_screencast_set_refresh_interval (KASASA_SCREENCAST (content),
+                                          (guint) gtk_spin_button_get_value_as_int (spin_button));
+}
+
+static void
+on_refresh_button_active (GObject    *object,
+                          GParamSpec *pspec,
+                          gpointer    user_data)
+{
+  KasasaContentContainer *self = KASASA_CONTENT_CONTAINER (user_data);
+  KasasaWindow *window = kasasa_window_get_window_reference (GTK_WIDGET (self));
+
+  kasasa_window_block_miniaturization (window,
+                                       gtk_menu_button_get_active (self->refresh_button));
+}
+
 static void
 on_page_changed (AdwCarousel *carousel,
                  guint        index,
@@ -719,23 +1724,32 @@ on_page_changed (AdwCarousel *carousel,
   // Ensure that the window is visible
   kasasa_window_change_opacity (window, OPACITY_INCREASE);
 
+  update_materialized_contents (self, index);
+
   g_debug ("Resizing window for content at index %d due to page change", index);
   content = get_current_content (self);
 
-  if (KASASA_IS_SCREENCAST (content))
-    {
-      gtk_widget_set_sensitive (GTK_WIDGET (self->copy_screenshot_button),
-                                FALSE);
-      gtk_widget_set_sensitive (GTK_WIDGET (self->retake_screenshot_button),
-                                FALSE);
-    }
-  else
-    {
-      gtk_widget_set_sensitive (GTK_WIDGET (self->copy_screenshot_button),
-                                TRUE);
-      gtk_widget_set_sensitive (GTK_WIDGET (self->retake_screenshot_button),
-                                TRUE);
-    }
+  // The current frame of a screencast can be copied, but not retaken
+  gtk_widget_set_sensitive (GTK_WIDGET (self->copy_screenshot_button),
+                            TRUE);
+  gtk_widget_set_sensitive (GTK_WIDGET (self->retake_screenshot_button),
+                            !KASASA_IS_SCREENCAST (content));
+  update_screencast_buttons (self, content);
+
+  // Show the watch mode of the current page
+  g_signal_handlers_block_by_func (self->watch_button, on_watch_button_toggled, self);
+  gtk_toggle_button_set_active (self->watch_button,
+                                KASASA_IS_SCREENCAST (content)
+                                && kasasa_screencast_get_watching (KASASA_SCREENCAST (content)));
+  g_signal_handlers_unblock_by_func (self->watch_button, on_watch_button_toggled, self);
+
+  // ...and its refresh interval
+  g_signal_handlers_block_by_func (self->refresh_interval_spin, on_refresh_interval_changed, self);
+  gtk_spin_button_set_value (self->refresh_interval_spin,
+                             KASASA_IS_SCREENCAST (content)
+                             ? kasasa_screencast_get_refresh_interval (KASASA_SCREENCAST (content))
+                             : 0);
+  g_signal_handlers_unblock_by_func (self->refresh_interval_spin, on_refresh_interval_changed, self);
 
   kasasa_content_get_dimensions (KASASA_CONTENT (content),
                                  &new_height,
@@ -751,14 +1765,16 @@ on_remove_content_clicked (GtkButton *button,
                            gpointer   user_data)
 {
   KasasaContentContainer *self = KASASA_CONTENT_CONTAINER (user_data);
-  gdouble current_position;
+  guint current_position;
+  guint neighbor_position;
   GtkWidget *current_content = get_current_content (self);
-  GtkWidget *neighbor_content = NULL;
+  GtkWidget *neighbor_slot = NULL;
 
   adw_carousel_set_interactive (self->carousel, FALSE);
 
   // Use the finish implementation for each class
   kasasa_content_finish (KASASA_CONTENT (current_content));
+  release_capture (self, get_item (self, get_current_position (self)));
 
   /*
    * After calling 'adw_carousel_remove ()' a 'page-changed' signal is not emitted,
@@ -768,59 +1784,48 @@ on_remove_content_clicked (GtkButton *button,
    * Workaround: get the neighbor content and forcibly scroll to it; to delete
    * a content, the window must hold at least 2 contents
    */
-  current_position = adw_carousel_get_position (self->carousel);
+  current_position = get_current_position (self);
   if (current_position == 0)
     {
       // If the deleted content is at index 0, get the next one...
-      neighbor_content = adw_carousel_get_nth_page (self->carousel,
-                                                    current_position+1);
+      neighbor_position = current_position + 1;
     }
   else
     {
       // ...otherwise, always get the previous one.
-      neighbor_content = adw_carousel_get_nth_page (self->carousel,
-                                                    current_position-1);
+      neighbor_position = current_position - 1;
     }
+  neighbor_slot = adw_carousel_get_nth_page (self->carousel, neighbor_position);
 
-  adw_carousel_remove (self->carousel, current_content);
+  remove_content (self, current_position);
 
-  adw_carousel_scroll_to (self->carousel, neighbor_content, TRUE);
+  // Both cases end up at the index of the previous one (or 0)
+  update_materialized_contents (self, (current_position == 0) ? 0 : neighbor_position);
+  adw_carousel_scroll_to (self->carousel, neighbor_slot, TRUE);
 
   kasasa_content_container_update_toolbar_sensibility (self);
 
   adw_carousel_set_interactive (self->carousel, TRUE);
 }
 
-// Copy the image to the clipboard
 static void
-on_copy_screenshot_button_clicked (GtkButton *button,
-                                   gpointer   user_data)
+copy_texture (KasasaContentContainer *self,
+              GdkTexture             *texture)
 {
-  KasasaContentContainer *self = KASASA_CONTENT_CONTAINER (user_data);
-  g_autoptr (GError) error = NULL;
   GdkClipboard *clipboard = NULL;
-  g_autoptr (GdkTexture) texture = NULL;
   AdwToast *toast = NULL;
-  GtkWidget *content = NULL;
-
-  content = get_current_content (self);
-
-  g_return_if_fail (KASASA_IS_SCREENSHOT (content));
 
   clipboard = gdk_display_get_clipboard (gdk_display_get_default ());
 
-  texture =
-    gdk_texture_new_from_file (kasasa_screenshot_get_file (KASASA_SCREENSHOT (content)),
-                               &error);
-
-  if (error != NULL)
+  if (texture == NULL)
     {
-      toast = adw_toast_new_format (_("Error: %s"), error->message);
-      adw_toast_set_action_target_value (toast, g_variant_new_string (error->message));
+      const gchar *error_message = _("Couldn't load the screenshot");
+      toast = adw_toast_new_format (_("Error: %s"), error_message);
+      adw_toast_set_action_target_value (toast, g_variant_new_string (error_message));
       adw_toast_set_button_label (toast, _("Copy"));
       adw_toast_set_action_name (toast, "toast.copy_error");
       adw_toast_overlay_add_toast (self->toast_overlay, toast);
-      g_warning ("%s", error->message);
+      g_warning ("%s", error_message);
 
       // Make the copy button insensitive on failure
       gtk_widget_set_sensitive (GTK_WIDGET (self->copy_screenshot_button), FALSE);
@@ -833,6 +1838,136 @@ on_copy_screenshot_button_clicked (GtkButton *button,
   adw_toast_overlay_add_toast (self->toast_overlay, toast);
 }
 
+static void
+on_frame_to_copy_received (GObject      *source_object,
+                           GAsyncResult *res,
+                           gpointer      user_data)
+{
+  g_autoptr (KasasaContentContainer) self = KASASA_CONTENT_CONTAINER (user_data);
+  g_autoptr (GdkTexture) texture = NULL;
+  g_autoptr (GError) error = NULL;
+
+  texture = kasasa_screencast_get_frame_finish (KASASA_SCREENCAST (source_object),
+                                                res, NULL, &error);
+  if (error != NULL)
+    g_debug ("%s", error->message);
+
+  // The window was closed while waiting for the frame
+  if (self->contents == NULL)
+    return;
+
+  copy_texture (self, texture);
+}
+
+// Copy the image to the clipboard
+static void
+on_copy_screenshot_button_clicked (GtkButton *button,
+                                   gpointer   user_data)
+{
+  KasasaContentContainer *self = KASASA_CONTENT_CONTAINER (user_data);
+  g_autoptr (GdkTexture) texture = NULL;
+  GtkWidget *content = NULL;
+
+  content = get_current_content (self);
+
+  g_return_if_fail (KASASA_IS_SCREENSHOT (content) || KASASA_IS_SCREENCAST (content));
+
+  // Copy the current frame of the screencast, waiting for one if needed
+  if (KASASA_IS_SCREENCAST (content))
+    {
+      kasasa_screencast_get_frame_async (KASASA_SCREENCAST (content),
+                                         on_frame_to_copy_received,
+                                         g_object_ref (self));
+      return;
+    }
+
+  // Reuse the texture already decoded by the screenshot
+  texture = kasasa_screenshot_get_texture (KASASA_SCREENSHOT (content));
+  copy_texture (self, texture);
+}
+
+// Pin the frame of the screencast as a new page
+static void
+pin_frame (KasasaContentContainer *self,
+           GdkTexture             *texture)
+{
+  g_autoptr (KasasaContentItem) item = NULL;
+  g_autoptr (KasasaTextureRegion) region = NULL;
+  KasasaScreenshot *screenshot = NULL;
+  GtkWidget *slot = NULL;
+  graphene_rect_t bounds;
+
+  if (g_list_model_get_n_items (G_LIST_MODEL (self->contents)) >= MAX_N_CONTENTS)
+    {
+      g_warning ("Max number of contents reached");
+      return;
+    }
+
+  if (texture == NULL)
+    {
+      const gchar *error_message = _("Couldn't get the current frame");
+      AdwToast *toast = adw_toast_new_format (_("Error: %s"), error_message);
+      adw_toast_set_action_target_value (toast, g_variant_new_string (error_message));
+      adw_toast_set_button_label (toast, _("Copy"));
+      adw_toast_set_action_name (toast, "toast.copy_error");
+      adw_toast_overlay_add_toast (self->toast_overlay, toast);
+      g_warning ("%s", error_message);
+      return;
+    }
+
+  // The frame has no file; it's shown as a region covering the whole texture
+  graphene_rect_init (&bounds, 0, 0,
+                      gdk_texture_get_width (texture),
+                      gdk_texture_get_height (texture));
+  region = kasasa_texture_region_new (texture, &bounds);
+
+  item = kasasa_content_item_new (CONTENT_TYPE_SCREENSHOT);
+  kasasa_content_item_set_region (item, region);
+
+  screenshot = kasasa_screenshot_new ();
+  slot = append_content (self, item, GTK_WIDGET (screenshot));
+  kasasa_screenshot_show_region (screenshot, region);
+  adw_carousel_scroll_to (self->carousel, slot, TRUE);
+
+  kasasa_content_container_update_toolbar_sensibility (self);
+}
+
+static void
+on_frame_to_pin_received (GObject      *source_object,
+                          GAsyncResult *res,
+                          gpointer      user_data)
+{
+  g_autoptr (KasasaContentContainer) self = KASASA_CONTENT_CONTAINER (user_data);
+  g_autoptr (GdkTexture) texture = NULL;
+  g_autoptr (GError) error = NULL;
+
+  texture = kasasa_screencast_get_frame_finish (KASASA_SCREENCAST (source_object),
+                                                res, NULL, &error);
+  if (error != NULL)
+    g_debug ("%s", error->message);
+
+  // The window was closed while waiting for the frame
+  if (self->contents == NULL)
+    return;
+
+  pin_frame (self, texture);
+}
+
+// Pin the current frame of the screencast, waiting for one if needed
+static void
+on_freeze_frame_button_clicked (GtkButton *button,
+                                gpointer   user_data)
+{
+  KasasaContentContainer *self = KASASA_CONTENT_CONTAINER (user_data);
+  GtkWidget *content = get_current_content (self);
+
+  g_return_if_fail (KASASA_IS_SCREENCAST (content));
+
+  kasasa_screencast_get_frame_async (KASASA_SCREENCAST (content),
+                                     on_frame_to_pin_received,
+                                     g_object_ref (self));
+}
+
 static void
 on_menu_button_active (GObject    *object,
                        GParamSpec *pspec,
@@ -842,7 +1977,18 @@ on_menu_button_active (GObject    *object,
   KasasaWindow *window = kasasa_window_get_window_reference (GTK_WIDGET (self));
 
   if (gtk_menu_button_get_active (self->more_actions_button))
-    kasasa_window_block_miniaturization (window, TRUE);
+    {
+      GtkWidget *content = get_current_content (self);
+
+      kasasa_window_block_miniaturization (window, TRUE);
+      // The user may start a screencast from this popover
+      kasasa_screencast_preload ();
+
+      // A running screencast can be shown again, sharing its stream
+      gtk_widget_set_visible (GTK_WIDGET (self->duplicate_screencast_button),
+                              KASASA_IS_SCREENCAST (content)
+                              && kasasa_screencast_get_stream (KASASA_SCREENCAST (content)) != NULL);
+    }
   else
     kasasa_window_block_miniaturization (window, FALSE);
 }
@@ -867,6 +2013,10 @@ kasasa_content_container_dispose (GObject *object)
 
   g_clear_object (&self->portal);
   g_clear_object (&self->settings);
+  g_clear_object (&self->contents);
+  g_clear_pointer (&self->regions_uri, g_free);
+  g_clear_handle_id (&self->region_frame_source, g_source_remove);
+  g_clear_weak_pointer (&self->selecting_screencast);
   if (self->parent)
     xdp_parent_free (self->parent);
 
@@ -893,9 +2043,16 @@ kasasa_content_container_class_init (KasasaContentContainerClass *klass)
   gtk_widget_class_bind_template_child (widget_class, KasasaContentContainer, retake_screenshot_button);
   gtk_widget_class_bind_template_child (widget_class, KasasaContentContainer, add_screenshot_button);
   gtk_widget_class_bind_template_child (widget_class, KasasaContentContainer, add_delayed_screenshot_button);
+  gtk_widget_class_bind_template_child (widget_class, KasasaContentContainer, add_regions_button);
   gtk_widget_class_bind_template_child (widget_class, KasasaContentContainer, add_screencast_button);
+  gtk_widget_class_bind_template_child (widget_class, KasasaContentContainer, add_screencast_region_button);
+  gtk_widget_class_bind_template_child (widget_class, KasasaContentContainer, duplicate_screencast_button);
   gtk_widget_class_bind_template_child (widget_class, KasasaContentContainer, remove_content_button);
   gtk_widget_class_bind_template_child (widget_class, KasasaContentContainer, copy_screenshot_button);
+  gtk_widget_class_bind_template_child (widget_class, KasasaContentContainer, freeze_frame_button);
+  gtk_widget_class_bind_template_child (widget_class, KasasaContentContainer, watch_button);
+  gtk_widget_class_bind_template_child (widget_class, KasasaContentContainer, refresh_button);
+  gtk_widget_class_bind_template_child (widget_class, KasasaContentContainer, refresh_interval_spin);
   gtk_widget_class_bind_template_child (widget_class, KasasaContentContainer, more_actions_button);
   gtk_widget_class_bind_template_child (widget_class, KasasaContentContainer, revealer_start_buttons);
   gtk_widget_class_bind_template_child (widget_class, KasasaContentContainer, revealer_end_buttons);
@@ -912,13 +2069,19 @@ kasasa_content_container_init (KasasaContentContainer *self)
 
   self->portal = xdp_portal_new ();
   self->parent = NULL;
-  self->settings = g_settings_new ("io.github.kelvinnovais.Kasasa");
+  self->settings = g_object_ref (kasasa_settings_get_default ());
+  self->contents = g_list_store_new (KASASA_TYPE_CONTENT_ITEM);
+  self->materialized_center = G_MAXUINT;
 
   // Signals
   g_signal_connect (self->carousel,
                     "page-changed",
                     G_CALLBACK (on_page_changed),
                     self);
+  g_signal_connect (self->carousel,
+                    "notify::position",
+                    G_CALLBACK (on_position_changed),
+                    self);
   g_signal_connect (self->retake_screenshot_button,
                     "clicked",
                     G_CALLBACK (retake_screenshot),
@@ -931,10 +2094,22 @@ kasasa_content_container_init (KasasaContentContainer *self)
                     "clicked",
                     G_CALLBACK (take_delayed_screenshot),
                     self);
+  g_signal_connect (self->add_regions_button,
+                    "clicked",
+                    G_CALLBACK (take_regions_screenshot),
+                    self);
   g_signal_connect (self->add_screencast_button,
                     "clicked",
                     G_CALLBACK (create_screencast_session),
                     self);
+  g_signal_connect (self->add_screencast_region_button,
+                    "clicked",
+                    G_CALLBACK (create_screencast_region_session),
+                    self);
+  g_signal_connect (self->duplicate_screencast_button,
+                    "clicked",
+                    G_CALLBACK (duplicate_screencast),
+                    self);
   g_signal_connect (self->remove_content_button,
                     "clicked",
                     G_CALLBACK (on_remove_content_clicked),
@@ -943,6 +2118,22 @@ kasasa_content_container_init (KasasaContentContainer *self)
                     "clicked",
                     G_CALLBACK (on_copy_screenshot_button_clicked),
                     self);
+  g_signal_connect (self->freeze_frame_button,
+                    "clicked",
+                    G_CALLBACK (on_freeze_frame_button_clicked),
+                    self);
+  g_signal_connect (self->watch_button,
+                    "toggled",
+                    G_CALLBACK (on_watch_button_toggled),
+                    self);
+  g_signal_connect (self->refresh_button,
+                    "notify::active",
+                    G_CALLBACK (on_refresh_button_active),
+                    self);
+  g_signal_connect (self->refresh_interval_spin,
+                    "value-changed",
+                    G_CALLBACK (on_refresh_interval_changed),
+                    self);
   g_signal_connect (self->more_actions_button,
                     "notify::active",
                     G_CALLBACK (on_menu_button_active),
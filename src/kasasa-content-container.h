@@ -25,7 +25,9 @@
 
 G_BEGIN_DECLS
 
-#define MAX_N_CONTENTS 5
+#define MAX_N_CONTENTS 50
+// Pages at each side of the current one that keep a built widget
+#define N_MATERIALIZED_NEIGHBORS 1
 
 #define KASASA_TYPE_CONTENT_CONTAINER (kasasa_content_container_get_type ())
 
@@ -43,5 +45,13 @@ void kasasa_content_container_reveal_controls (KasasaContentContainer *cc,
 gboolean kasasa_content_container_controls_active (KasasaContentContainer *cc);
 
 void kasasa_content_container_wipe_content (KasasaContentContainer *cc);
+void kasasa_content_container_trim_contents (KasasaContentContainer *cc);
+void kasasa_content_container_restore_contents (KasasaContentContainer *cc);
+GdkTexture *
+kasasa_content_container_get_thumbnail (KasasaContentContainer *cc,
+                                        gint                    size);
+GdkPaintable *
+kasasa_content_container_get_live_thumbnail (KasasaContentContainer *cc,
+                                             gint                    size);
 
 G_END_DECLS
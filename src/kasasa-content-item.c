@@ -0,0 +1,195 @@
+/* kasasa-content-item.c
+ *
+ * Copyright 2026 Kelvin Novais
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "kasasa-content-item.h"
+#include "kasasa-content.h"
+
+/*
+ * KasasaContentItem is a lightweight description of a content of the
+ * carousel. Only some items have a widget (KasasaScreenshot or
+ * KasasaScreencast) at a time; the others only keep what's needed to build it
+ * again.
+ */
+
+struct _KasasaContentItem
+{
+  GObject                  parent_instance;
+
+  /* Instance variables */
+  ContentType              content_type;
+  gchar                   *uri;
+  // Region of a shared capture, shown instead of the image at uri
+  KasasaTextureRegion     *region;
+  // Stream of the window retaken with fast retake
+  KasasaFrameSource       *frame_source;
+  GtkWidget               *widget;
+  // Last known dimensions, used while there's no widget
+  gint                     height;
+  gint                     width;
+};
+
+G_DEFINE_FINAL_TYPE (KasasaContentItem, kasasa_content_item, G_TYPE_OBJECT)
+
+ContentType
+kasasa_content_item_get_content_type (KasasaContentItem *self)
+{
+  g_return_val_if_fail (KASASA_IS_CONTENT_ITEM (self), CONTENT_TYPE_SCREENSHOT);
+
+  return self->content_type;
+}
+
+const gchar *
+kasasa_content_item_get_uri (KasasaContentItem *self)
+{
+  g_return_val_if_fail (KASASA_IS_CONTENT_ITEM (self), NULL);
+
+  return self->uri;
+}
+
+void
+kasasa_content_item_set_uri (KasasaContentItem *self,
+                             const gchar       *uri)
+{
+  g_return_if_fail (KASASA_IS_CONTENT_ITEM (self));
+
+  g_free (self->uri);
+  self->uri = g_strdup (uri);
+}
+
+KasasaTextureRegion *
+kasasa_content_item_get_region (KasasaContentItem *self)
+{
+  g_return_val_if_fail (KASASA_IS_CONTENT_ITEM (self), NULL);
+
+  return self->region;
+}
+
+void
+kasasa_content_item_set_region (KasasaContentItem   *self,
+                                KasasaTextureRegion *region)
+{
+  g_return_if_fail (KASASA_IS_CONTENT_ITEM (self));
+
+  g_set_object (&self->region, region);
+}
+
+KasasaFrameSource *
+kasasa_content_item_get_frame_source (KasasaContentItem *self)
+{
+  g_return_val_if_fail (KASASA_IS_CONTENT_ITEM (self), NULL);
+
+  return self->frame_source;
+}
+
+void
+kasasa_content_item_set_frame_source (KasasaContentItem *self,
+                                      KasasaFrameSource *frame_source)
+{
+  g_return_if_fail (KASASA_IS_CONTENT_ITEM (self));
+
+  g_set_object (&self->frame_source, frame_source);
+}
+
+// Returns the widget of the item, or NULL if it isn't materialized
+GtkWidget *
+kasasa_content_item_get_widget (KasasaContentItem *self)
+{
+  g_return_val_if_fail (KASASA_IS_CONTENT_ITEM (self), NULL);
+
+  return self->widget;
+}
+
+void
+kasasa_content_item_set_widget (KasasaContentItem *self,
+                                GtkWidget         *widget)
+{
+  g_return_if_fail (KASASA_IS_CONTENT_ITEM (self));
+  g_return_if_fail (widget == NULL || KASASA_IS_CONTENT (widget));
+
+  // Keep the dimensions of the widget that is going away
+  if (self->widget != NULL && widget == NULL)
+    kasasa_content_get_dimensions (KASASA_CONTENT (self->widget),
+                                   &self->height,
+                                   &self->width);
+
+  g_set_object (&self->widget, widget);
+}
+
+void
+kasasa_content_item_get_dimensions (KasasaContentItem *self,
+                                    gint              *height,
+                                    gint              *width)
+{
+  g_return_if_fail (KASASA_IS_CONTENT_ITEM (self));
+
+  if (self->widget != NULL)
+    kasasa_content_get_dimensions (KASASA_CONTENT (self->widget),
+                                   &self->height,
+                                   &self->width);
+
+  *height = self->height;
+  *width = self->width;
+}
+
+static void
+kasasa_content_item_dispose (GObject *object)
+{
+  KasasaContentItem *self = KASASA_CONTENT_ITEM (object);
+
+  g_clear_object (&self->widget);
+  g_clear_object (&self->region);
+  g_clear_object (&self->frame_source);
+
+  G_OBJECT_CLASS (kasasa_content_item_parent_class)->dispose (object);
+}
+
+static void
+kasasa_content_item_finalize (GObject *object)
+{
+  KasasaContentItem *self = KASASA_CONTENT_ITEM (object);
+
+  g_free (self->uri);
+
+  G_OBJECT_CLASS (kasasa_content_item_parent_class)->finalize (object);
+}
+
+static void
+kasasa_content_item_class_init (KasasaContentItemClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->dispose = kasasa_content_item_dispose;
+  object_class->finalize = kasasa_content_item_finalize;
+}
+
+static void
+kasasa_content_item_init (KasasaContentItem *self)
+{
+}
+
+KasasaContentItem *
+kasasa_content_item_new (ContentType content_type)
+{
+  KasasaContentItem *self = g_object_new (KASASA_TYPE_CONTENT_ITEM, NULL);
+
+  self->content_type = content_type;
+
+  return self;
+}
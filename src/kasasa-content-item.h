@@ -0,0 +1,58 @@
+/* kasasa-content-item.h
+ *
+ * Copyright 2026 Kelvin Novais
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gtk/gtk.h>
+
+#include "kasasa-texture-region.h"
+#include "kasasa-frame-source.h"
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+  CONTENT_TYPE_SCREENSHOT,
+  CONTENT_TYPE_SCREENCAST
+} ContentType;
+
+#define KASASA_TYPE_CONTENT_ITEM (kasasa_content_item_get_type ())
+
+G_DECLARE_FINAL_TYPE (KasasaContentItem, kasasa_content_item, KASASA, CONTENT_ITEM, GObject)
+
+KasasaContentItem *kasasa_content_item_new (ContentType content_type);
+ContentType kasasa_content_item_get_content_type (KasasaContentItem *item);
+const gchar *kasasa_content_item_get_uri (KasasaContentItem *item);
+void kasasa_content_item_set_uri (KasasaContentItem *item,
+                                  const gchar       *uri);
+KasasaTextureRegion *kasasa_content_item_get_region (KasasaContentItem *item);
+void kasasa_content_item_set_region (KasasaContentItem   *item,
+                                     KasasaTextureRegion *region);
+KasasaFrameSource *kasasa_content_item_get_frame_source (KasasaContentItem *item);
+void kasasa_content_item_set_frame_source (KasasaContentItem *item,
+                                           KasasaFrameSource *frame_source);
+GtkWidget *kasasa_content_item_get_widget (KasasaContentItem *item);
+void kasasa_content_item_set_widget (KasasaContentItem *item,
+                                     GtkWidget         *widget);
+void kasasa_content_item_get_dimensions (KasasaContentItem *item,
+                                         gint              *height,
+                                         gint              *width);
+
+G_END_DECLS
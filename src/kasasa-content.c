@@ -50,15 +50,100 @@ kasasa_content_finish (KasasaContent *self)
   iface->finish (self);
 }
 
+// Stop any ongoing work while the content isn't visible
+void
+kasasa_content_suspend (KasasaContent *self)
+{
+  KasasaContentInterface *iface = NULL;
+
+  g_return_if_fail (KASASA_IS_CONTENT (self));
+
+  iface = KASASA_CONTENT_GET_IFACE (self);
+  g_return_if_fail (iface->suspend != NULL);
+
+  iface->suspend (self);
+}
+
+// Undo kasasa_content_suspend () and kasasa_content_trim_memory ()
+void
+kasasa_content_resume (KasasaContent *self)
+{
+  KasasaContentInterface *iface = NULL;
+
+  g_return_if_fail (KASASA_IS_CONTENT (self));
+
+  iface = KASASA_CONTENT_GET_IFACE (self);
+  g_return_if_fail (iface->resume != NULL);
+
+  iface->resume (self);
+}
+
+void
+kasasa_content_trim_memory (KasasaContent    *self,
+                            ContentTrimLevel  level)
+{
+  KasasaContentInterface *iface = NULL;
+
+  g_return_if_fail (KASASA_IS_CONTENT (self));
+
+  iface = KASASA_CONTENT_GET_IFACE (self);
+  g_return_if_fail (iface->trim_memory != NULL);
+
+  iface->trim_memory (self, level);
+}
+
+// Returns an estimate of the memory held by the content, in bytes
+gsize
+kasasa_content_get_memory_usage (KasasaContent *self)
+{
+  KasasaContentInterface *iface = NULL;
+
+  g_return_val_if_fail (KASASA_IS_CONTENT (self), 0);
+
+  iface = KASASA_CONTENT_GET_IFACE (self);
+  g_return_val_if_fail (iface->get_memory_usage != NULL, 0);
+
+  return iface->get_memory_usage (self);
+}
+
 static void
 default_finish (KasasaContent *self)
 {
   return;
 }
 
+static void
+default_suspend (KasasaContent *self)
+{
+  return;
+}
+
+static void
+default_resume (KasasaContent *self)
+{
+  return;
+}
+
+static void
+default_trim_memory (KasasaContent    *self,
+                     ContentTrimLevel  level)
+{
+  return;
+}
+
+static gsize
+default_get_memory_usage (KasasaContent *self)
+{
+  return 0;
+}
+
 static void
 kasasa_content_default_init (KasasaContentInterface *iface)
 {
   iface->finish = default_finish;
+  iface->suspend = default_suspend;
+  iface->resume = default_resume;
+  iface->trim_memory = default_trim_memory;
+  iface->get_memory_usage = default_get_memory_usage;
 }
 
@@ -24,6 +24,16 @@
 
 G_BEGIN_DECLS
 
+typedef enum
+{
+  // Drop caches that aren't needed to present the content
+  CONTENT_TRIM_LEVEL_MODERATE,
+  // Keep presenting the content, but with less quality
+  CONTENT_TRIM_LEVEL_DEGRADE,
+  // Drop everything that can be rebuilt on resume, including what is shown
+  CONTENT_TRIM_LEVEL_COMPLETE
+} ContentTrimLevel;
+
 #define KASASA_TYPE_CONTENT (kasasa_content_get_type ())
 
 G_DECLARE_INTERFACE (KasasaContent, kasasa_content, KASASA, CONTENT, GObject)
@@ -37,6 +47,15 @@ struct _KasasaContentInterface
                            gint           *width);
 
   void (* finish) (KasasaContent *content);
+
+  void (* suspend) (KasasaContent *content);
+
+  void (* resume) (KasasaContent *content);
+
+  void (* trim_memory) (KasasaContent    *content,
+                        ContentTrimLevel  level);
+
+  gsize (* get_memory_usage) (KasasaContent *content);
 };
 
 void kasasa_content_get_dimensions (KasasaContent *content,
@@ -45,4 +64,13 @@ void kasasa_content_get_dimensions (KasasaContent *content,
 
 void kasasa_content_finish (KasasaContent *content);
 
+void kasasa_content_suspend (KasasaContent *content);
+
+void kasasa_content_resume (KasasaContent *content);
+
+void kasasa_content_trim_memory (KasasaContent    *content,
+                                 ContentTrimLevel  level);
+
+gsize kasasa_content_get_memory_usage (KasasaContent *content);
+
 G_END_DECLS
@@ -0,0 +1,697 @@
+/* kasasa-frame-source.c
+ *
+ * Copyright 2026 Kelvin Novais
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <glib/gi18n.h>
+#include <gst/video/video.h>
+#include <math.h>
+#include <string.h>
+
+#include "kasasa-frame-source.h"
+#include "kasasa-screencast.h"
+
+/*
+ * KasasaFrameSource keeps a screencast session of a window, so frames of it can
+ * be grabbed without going through the portal again. The window is chosen on
+ * the first grab; if the session is closed, the restore token is used to start
+ * a new one without asking the user.
+ *
+ * The pipeline is only played while a grab is pending, and paused once it is
+ * served. Windows that didn't change may send no new frame when the pipeline
+ * is resumed; after FRAME_TIMEOUT the last received frame is used instead.
+ *
+ * pipewiresrc ! videoconvert ! capsfilter (BGRx) ! fakesink (last sample)
+ */
+
+struct _KasasaFrameSource
+{
+  GObject                  parent_instance;
+
+  /* Instance variables */
+  XdpPortal               *portal;
+  XdpParent               *parent;
+  XdpSession              *session;
+  gulong                   closed_handler_id;
+  gchar                   *restore_token;
+  GstElement              *pipeline;
+  GstElement              *fakesink;
+  // Grabs waiting for the session or for a frame
+  GPtrArray               *pending_grabs;
+  gint                     waiting_frame;
+  guint                    frame_timeout_source;
+};
+
+#define FRAME_TIMEOUT 250 // milliseconds
+
+G_DEFINE_FINAL_TYPE (KasasaFrameSource, kasasa_frame_source, G_TYPE_OBJECT)
+
+/*
+ * Video info of raw or dmabuf caps. Screencasts only negotiate linear dmabufs,
+ * which are mapped as the packed format they hold
+ */
+gboolean
+kasasa_frame_info_from_caps (GstCaps      *caps,
+                             GstVideoInfo *info)
+{
+  GstVideoInfoDmaDrm drm_info;
+
+  g_return_val_if_fail (caps != NULL, FALSE);
+
+  if (!gst_video_is_dma_drm_caps (caps))
+    return gst_video_info_from_caps (info, caps);
+
+  // 0 is DRM_FORMAT_MOD_LINEAR
+  return gst_video_info_dma_drm_from_caps (&drm_info, caps)
+         && drm_info.drm_modifier == 0
+         && gst_video_info_dma_drm_to_video_info (&drm_info, info);
+}
+
+// Map a BGRx sample for reading; the plane offsets and strides are taken from
+// the video meta of the buffer, if any. Unmap with gst_video_frame_unmap ()
+static gboolean
+map_frame (GstSample     *sample,
+           GstVideoFrame *frame)
+{
+  GstBuffer *buffer = gst_sample_get_buffer (sample);
+  GstCaps *caps = gst_sample_get_caps (sample);
+  GstVideoInfo info;
+
+  if (buffer == NULL || caps == NULL || !kasasa_frame_info_from_caps (caps, &info))
+    return FALSE;
+
+  if (GST_VIDEO_INFO_FORMAT (&info) != GST_VIDEO_FORMAT_BGRx)
+    {
+      g_warning ("Expected a BGRx frame, but received: %s",
+                 gst_video_format_to_string (GST_VIDEO_INFO_FORMAT (&info)));
+      return FALSE;
+    }
+
+  return gst_video_frame_map (frame, &info, buffer, GST_MAP_READ);
+}
+
+/*
+ * Get the bounding box of the non black pixels of a BGRx sample (window
+ * screencasts are padded with black); the whole frame if it's all black
+ */
+gboolean
+kasasa_frame_get_content_bounds (GstSample       *sample,
+                                 graphene_rect_t *bounds)
+{
+  GstVideoFrame frame;
+  const guchar *data = NULL;
+  gint top, bottom = -1, left, right = -1;
+  gint width, height, stride;
+
+  g_return_val_if_fail (sample != NULL, FALSE);
+
+  if (!map_frame (sample, &frame))
+    return FALSE;
+
+  width = GST_VIDEO_FRAME_WIDTH (&frame);
+  height = GST_VIDEO_FRAME_HEIGHT (&frame);
+  stride = GST_VIDEO_FRAME_PLANE_STRIDE (&frame, 0);
+  data = GST_VIDEO_FRAME_PLANE_DATA (&frame, 0);
+
+  top = height;
+  left = width;
+
+  for (gint y = 0; y < height; y++)
+    {
+      const guchar *row = data + (gsize) y * stride;
+
+      for (gint x = 0; x < width; x++)
+        {
+          const guchar *pixel = row + x * 4;
+
+          // Check if the pixel is not black (ignoring the X channel)
+          if (pixel[0] != 0 || pixel[1] != 0 || pixel[2] != 0)
+            {
+              top = MIN (top, y);
+              bottom = MAX (bottom, y);
+              left = MIN (left, x);
+              right = MAX (right, x);
+            }
+        }
+    }
+
+  gst_video_frame_unmap (&frame);
+
+  if (bottom < 0)
+    graphene_rect_init (bounds, 0, 0, width, height);
+  else
+    graphene_rect_init (bounds, left, top, right - left + 1, bottom - top + 1);
+
+  return TRUE;
+}
+
+/*
+ * Copy a BGRx sample to a texture, without converting nor encoding it. If crop
+ * is not NULL, only that part of the frame is copied. The rows are copied
+ * rather than wrapped: textures are kept by the pages for as long as they're
+ * shown, and holding the buffers would exhaust the PipeWire buffer pool
+ */
+GdkTexture *
+kasasa_frame_texture_new (GstSample             *sample,
+                          const graphene_rect_t *crop)
+{
+  g_autoptr (GBytes) bytes = NULL;
+  GstVideoFrame frame;
+  const guchar *frame_data = NULL;
+  guchar *data = NULL;
+  gint x = 0, y = 0, width, height;
+  gint frame_width, frame_height, stride;
+  gsize row_size;
+
+  g_return_val_if_fail (sample != NULL, NULL);
+
+  if (!map_frame (sample, &frame))
+    return NULL;
+
+  frame_width = GST_VIDEO_FRAME_WIDTH (&frame);
+  frame_height = GST_VIDEO_FRAME_HEIGHT (&frame);
+  stride = GST_VIDEO_FRAME_PLANE_STRIDE (&frame, 0);
+  frame_data = GST_VIDEO_FRAME_PLANE_DATA (&frame, 0);
+
+  width = frame_width;
+  height = frame_height;
+  if (crop != NULL)
+    {
+      x = CLAMP ((gint) roundf (crop->origin.x), 0, frame_width - 1);
+      y = CLAMP ((gint) roundf (crop->origin.y), 0, frame_height - 1);
+      width = CLAMP ((gint) roundf (crop->size.width), 1, frame_width - x);
+      height = CLAMP ((gint) roundf (crop->size.height), 1, frame_height - y);
+    }
+
+  row_size = (gsize) width * 4;
+  data = g_malloc (row_size * height);
+  for (gint row = 0; row < height; row++)
+    memcpy (data + row * row_size,
+            frame_data + (gsize) (y + row) * stride + (gsize) x * 4,
+            row_size);
+
+  gst_video_frame_unmap (&frame);
+
+  bytes = g_bytes_new_take (data, row_size * height);
+
+  return gdk_memory_texture_new (width, height, GDK_MEMORY_B8G8R8X8, bytes, row_size);
+}
+
+/*
+ * Compute a small signature of a BGRx sample: the average luma of each block
+ * of a grid_size x grid_size grid over the crop (or the whole frame). Only
+ * some pixels of each block are read. Returns NULL on failure; free with
+ * g_free ()
+ */
+guint8 *
+kasasa_frame_get_signature (GstSample             *sample,
+                            const graphene_rect_t *crop,
+                            guint                  grid_size)
+{
+  GstVideoFrame frame;
+  const guchar *data = NULL;
+  guint8 *signature = NULL;
+  gint x = 0, y = 0, width, height;
+  gint frame_width, frame_height, stride;
+
+  g_return_val_if_fail (sample != NULL, NULL);
+  g_return_val_if_fail (grid_size > 0, NULL);
+
+  if (!map_frame (sample, &frame))
+    return NULL;
+
+  frame_width = GST_VIDEO_FRAME_WIDTH (&frame);
+  frame_height = GST_VIDEO_FRAME_HEIGHT (&frame);
+  stride = GST_VIDEO_FRAME_PLANE_STRIDE (&frame, 0);
+  data = GST_VIDEO_FRAME_PLANE_DATA (&frame, 0);
+
+  width = frame_width;
+  height = frame_height;
+  if (crop != NULL)
+    {
+      x = CLAMP ((gint) crop->origin.x, 0, frame_width - 1);
+      y = CLAMP ((gint) crop->origin.y, 0, frame_height - 1);
+      width = CLAMP ((gint) crop->size.width, 1, frame_width - x);
+      height = CLAMP ((gint) crop->size.height, 1, frame_height - y);
+    }
+
+  signature = g_new0 (guint8, grid_size * grid_size);
+
+  for (guint block_y = 0; block_y < grid_size; block_y++)
+    {
+      gint y0 = y + (gint) (block_y * height / grid_size);
+      gint y1 = y + (gint) ((block_y + 1) * height / grid_size);
+
+      for (guint block_x = 0; block_x < grid_size; block_x++)
+        {
+          gint x0 = x + (gint) (block_x * width / grid_size);
+          gint x1 = x + (gint) ((block_x + 1) * width / grid_size);
+          guint64 sum = 0, n_pixels = 0;
+
+          // Every 4th pixel of every 4th row is enough to notice a change
+          for (gint py = y0; py < MAX (y1, y0 + 1); py += 4)
+            for (gint px = x0; px < MAX (x1, x0 + 1); px += 4)
+              {
+                const guchar *pixel = data + (gsize) py * stride + (gsize) px * 4;
+
+                // Integer approximation of the luma (B, G, R, X)
+                sum += (pixel[2] * 77 + pixel[1] * 150 + pixel[0] * 29) >> 8;
+                n_pixels++;
+              }
+
+          signature[block_y * grid_size + block_x] = (guint8) (sum / MAX (n_pixels, 1));
+        }
+    }
+
+  gst_video_frame_unmap (&frame);
+
+  return signature;
+}
+
+static void
+stop_session (KasasaFrameSource *self)
+{
+  g_clear_handle_id (&self->frame_timeout_source, g_source_remove);
+  g_atomic_int_set (&self->waiting_frame, FALSE);
+
+  if (self->pipeline != NULL)
+    {
+      gst_element_set_state (self->pipeline, GST_STATE_NULL);
+      g_clear_pointer (&self->pipeline, gst_object_unref);
+      self->fakesink = NULL;
+    }
+
+  if (self->session != NULL)
+    {
+      g_clear_signal_handler (&self->closed_handler_id, self->session);
+      xdp_session_close (self->session);
+      g_clear_object (&self->session);
+    }
+}
+
+static void
+fail_pending_grabs (KasasaFrameSource *self,
+                    const GError      *error)
+{
+  g_autoptr (GPtrArray) pending_grabs = NULL;
+
+  // Callbacks may request new grabs
+  pending_grabs = g_steal_pointer (&self->pending_grabs);
+  self->pending_grabs = g_ptr_array_new_with_free_func (g_object_unref);
+
+  for (guint i = 0; i < pending_grabs->len; i++)
+    g_task_return_error (g_ptr_array_index (pending_grabs, i), g_error_copy (error));
+}
+
+static KasasaTextureRegion *
+grab_frame (KasasaFrameSource  *self,
+            GError            **error)
+{
+  g_autoptr (GstSample) sample = NULL;
+  g_autoptr (GdkTexture) texture = NULL;
+  graphene_rect_t content;
+
+  if (self->fakesink != NULL)
+    g_object_get (self->fakesink,
+                  "last-sample", &sample,
+                  NULL);
+
+  // Only the content of the window is copied
+  if (sample == NULL
+      || !kasasa_frame_get_content_bounds (sample, &content)
+      || (texture = kasasa_frame_texture_new (sample, &content)) == NULL)
+    {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                           _("Couldn't grab a frame of the window"));
+      return NULL;
+    }
+
+  graphene_rect_init (&content, 0, 0,
+                      gdk_texture_get_width (texture),
+                      gdk_texture_get_height (texture));
+
+  return kasasa_texture_region_new (texture, &content);
+}
+
+static void
+complete_pending_grabs (KasasaFrameSource *self)
+{
+  g_autoptr (GPtrArray) pending_grabs = NULL;
+  g_autoptr (KasasaTextureRegion) region = NULL;
+  g_autoptr (GError) error = NULL;
+
+  g_clear_handle_id (&self->frame_timeout_source, g_source_remove);
+
+  region = grab_frame (self, &error);
+
+  // Nothing else to serve; stop converting frames until the next grab
+  if (self->pipeline != NULL)
+    gst_element_set_state (self->pipeline, GST_STATE_PAUSED);
+
+  if (region == NULL)
+    {
+      fail_pending_grabs (self, error);
+      return;
+    }
+
+  pending_grabs = g_steal_pointer (&self->pending_grabs);
+  self->pending_grabs = g_ptr_array_new_with_free_func (g_object_unref);
+
+  for (guint i = 0; i < pending_grabs->len; i++)
+    g_task_return_pointer (g_ptr_array_index (pending_grabs, i),
+                           g_object_ref (region), g_object_unref);
+}
+
+static gboolean
+on_frame_received (gpointer user_data)
+{
+  KasasaFrameSource *self = KASASA_FRAME_SOURCE (user_data);
+
+  // The session may have been stopped, or restarted, meanwhile
+  if (self->pipeline != NULL
+      && self->pending_grabs->len > 0
+      && !g_atomic_int_get (&self->waiting_frame))
+    complete_pending_grabs (self);
+
+  return G_SOURCE_REMOVE;
+}
+
+// No new frame arrived: the window didn't change since the last one
+static gboolean
+on_frame_timeout (gpointer user_data)
+{
+  KasasaFrameSource *self = KASASA_FRAME_SOURCE (user_data);
+
+  self->frame_timeout_source = 0;
+
+  if (g_atomic_int_compare_and_exchange (&self->waiting_frame, TRUE, FALSE))
+    complete_pending_grabs (self);
+
+  return G_SOURCE_REMOVE;
+}
+
+// Called from the streaming thread
+static void
+on_handoff (GstElement *fakesink,
+            GstBuffer  *buffer,
+            GstPad     *pad,
+            gpointer    user_data)
+{
+  KasasaFrameSource *self = KASASA_FRAME_SOURCE (user_data);
+
+  if (g_atomic_int_compare_and_exchange (&self->waiting_frame, TRUE, FALSE))
+    g_main_context_invoke_full (NULL, G_PRIORITY_DEFAULT,
+                                on_frame_received,
+                                g_object_ref (self), g_object_unref);
+}
+
+static void
+on_session_closed (XdpSession *session,
+                   gpointer    user_data)
+{
+  KasasaFrameSource *self = KASASA_FRAME_SOURCE (user_data);
+  g_autoptr (GError) error = NULL;
+
+  g_info ("Frame source session closed");
+
+  // The restore token is kept, so the next grab doesn't ask for the window
+  stop_session (self);
+
+  error = g_error_new_literal (G_IO_ERROR, G_IO_ERROR_CLOSED,
+                               _("The window stream was closed"));
+  fail_pending_grabs (self, error);
+}
+
+static gboolean
+build_pipeline (KasasaFrameSource  *self,
+                gint                fd,
+                guint               node_id,
+                GError            **error)
+{
+  g_autofree gchar *node_id_str = NULL;
+  g_autoptr (GstCaps) caps = NULL;
+  GstElement *pipewire_element = NULL, *convert = NULL, *filter = NULL;
+
+  kasasa_screencast_ensure_gstreamer ();
+
+  node_id_str = g_strdup_printf ("%u", node_id);
+
+  self->pipeline = gst_pipeline_new ("frame_source");
+  pipewire_element = gst_element_factory_make ("pipewiresrc", NULL);
+  convert = gst_element_factory_make ("videoconvert", NULL);
+  filter = gst_element_factory_make ("capsfilter", NULL);
+  self->fakesink = gst_element_factory_make ("fakesink", NULL);
+
+  if (!self->pipeline || !pipewire_element || !convert || !filter || !self->fakesink)
+    {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                           "Not all elements could be created.");
+      return FALSE;
+    }
+
+  caps = gst_caps_from_string ("video/x-raw,format=BGRx");
+  g_object_set (filter, "caps", caps, NULL);
+  g_object_set (pipewire_element,
+                "fd", fd,
+                "path", node_id_str,
+                NULL);
+  g_object_set (self->fakesink,
+                "sync", FALSE,
+                "enable-last-sample", TRUE,
+                "signal-handoffs", TRUE,
+                NULL);
+  g_signal_connect (self->fakesink, "handoff", G_CALLBACK (on_handoff), self);
+
+  gst_bin_add_many (GST_BIN (self->pipeline),
+                    pipewire_element, convert, filter, self->fakesink, NULL);
+  if (!gst_element_link_many (pipewire_element, convert, filter, self->fakesink, NULL))
+    {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                           "Elements could not be linked.");
+      return FALSE;
+    }
+
+  g_atomic_int_set (&self->waiting_frame, TRUE);
+
+  if (gst_element_set_state (self->pipeline, GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE)
+    {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                           "Unable to set the pipeline to the playing state.");
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+on_session_started (GObject      *source_object,
+                    GAsyncResult *res,
+                    gpointer      user_data)
+{
+  g_autoptr (KasasaFrameSource) self = KASASA_FRAME_SOURCE (user_data);
+  g_autoptr (GError) error = NULL;
+  g_autoptr (GVariant) streams = NULL;
+  g_autoptr (GVariant) stream = NULL;
+  g_autofree gchar *restore_token = NULL;
+  guint node_id;
+  gint fd;
+
+  if (!xdp_session_start_finish (XDP_SESSION (source_object), res, &error))
+    goto FAIL;
+
+  // Keep the token to start a new session of the same window later
+  restore_token = xdp_session_get_restore_token (self->session);
+  if (restore_token != NULL)
+    {
+      g_free (self->restore_token);
+      self->restore_token = g_steal_pointer (&restore_token);
+    }
+
+  streams = xdp_session_get_streams (self->session);
+  if (streams == NULL || g_variant_n_children (streams) == 0)
+    {
+      error = g_error_new_literal (G_IO_ERROR, G_IO_ERROR_FAILED,
+                                   "The session has no streams");
+      goto FAIL;
+    }
+
+  stream = g_variant_get_child_value (streams, 0);
+  g_variant_get (stream, "(ua{sv})", &node_id, NULL);
+  fd = xdp_session_open_pipewire_remote (self->session);
+
+  if (!build_pipeline (self, fd, node_id, &error))
+    goto FAIL;
+
+  self->closed_handler_id = g_signal_connect (self->session, "closed",
+                                              G_CALLBACK (on_session_closed), self);
+  return;
+
+FAIL:
+  g_warning ("Couldn't start the frame source: %s", error->message);
+  stop_session (self);
+  fail_pending_grabs (self, error);
+}
+
+static void
+on_session_created (GObject      *source_object,
+                    GAsyncResult *res,
+                    gpointer      user_data)
+{
+  g_autoptr (KasasaFrameSource) self = KASASA_FRAME_SOURCE (user_data);
+  g_autoptr (GError) error = NULL;
+
+  self->session = xdp_portal_create_screencast_session_finish (XDP_PORTAL (source_object),
+                                                               res,
+                                                               &error);
+  if (error != NULL)
+    {
+      g_warning ("Failed to create the frame source session: %s", error->message);
+      fail_pending_grabs (self, error);
+      return;
+    }
+
+  xdp_session_start (self->session,
+                     self->parent,
+                     NULL,
+                     on_session_started,
+                     g_object_ref (self));
+}
+
+/*
+ * Grab a frame of the window, cropped to its content; the first call asks the
+ * user for the window. The frame source takes ownership of @parent, which is
+ * only used if a session has to be started
+ */
+void
+kasasa_frame_source_grab_async (KasasaFrameSource   *self,
+                                XdpParent           *parent,
+                                GAsyncReadyCallback  callback,
+                                gpointer             user_data)
+{
+  g_autoptr (GTask) task = NULL;
+  gboolean starting;
+
+  g_return_if_fail (KASASA_IS_FRAME_SOURCE (self));
+
+  task = g_task_new (self, NULL, callback, user_data);
+  g_task_set_source_tag (task, kasasa_frame_source_grab_async);
+
+  starting = (self->pending_grabs->len > 0);
+  g_ptr_array_add (self->pending_grabs, g_steal_pointer (&task));
+
+  // Wait for the session being started, or for the next frame
+  if (starting)
+    {
+      g_clear_pointer (&parent, xdp_parent_free);
+      return;
+    }
+
+  // Resume the paused pipeline, and wait for a frame newer than the last one
+  if (self->pipeline != NULL)
+    {
+      g_clear_pointer (&parent, xdp_parent_free);
+
+      g_atomic_int_set (&self->waiting_frame, TRUE);
+      self->frame_timeout_source = g_timeout_add (FRAME_TIMEOUT, on_frame_timeout, self);
+
+      if (gst_element_set_state (self->pipeline, GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE)
+        {
+          g_autoptr (GError) error = NULL;
+
+          error = g_error_new_literal (G_IO_ERROR, G_IO_ERROR_FAILED,
+                                       "Unable to set the pipeline to the playing state.");
+          stop_session (self);
+          fail_pending_grabs (self, error);
+        }
+      return;
+    }
+
+  g_clear_pointer (&self->parent, xdp_parent_free);
+  self->parent = parent;
+  xdp_portal_create_screencast_session (self->portal,
+                                        XDP_OUTPUT_WINDOW,
+                                        XDP_SCREENCAST_FLAG_NONE,
+                                        XDP_CURSOR_MODE_HIDDEN,
+                                        XDP_PERSIST_MODE_TRANSIENT,
+                                        self->restore_token,
+                                        NULL,
+                                        on_session_created,
+                                        g_object_ref (self));
+}
+
+KasasaTextureRegion *
+kasasa_frame_source_grab_finish (KasasaFrameSource  *self,
+                                 GAsyncResult       *result,
+                                 GError            **error)
+{
+  g_return_val_if_fail (KASASA_IS_FRAME_SOURCE (self), NULL);
+  g_return_val_if_fail (g_task_is_valid (result, self), NULL);
+
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+static void
+kasasa_frame_source_dispose (GObject *object)
+{
+  KasasaFrameSource *self = KASASA_FRAME_SOURCE (object);
+
+  stop_session (self);
+  g_clear_object (&self->portal);
+  g_clear_pointer (&self->parent, xdp_parent_free);
+
+  G_OBJECT_CLASS (kasasa_frame_source_parent_class)->dispose (object);
+}
+
+static void
+kasasa_frame_source_finalize (GObject *object)
+{
+  KasasaFrameSource *self = KASASA_FRAME_SOURCE (object);
+
+  g_free (self->restore_token);
+  g_ptr_array_unref (self->pending_grabs);
+
+  G_OBJECT_CLASS (kasasa_frame_source_parent_class)->finalize (object);
+}
+
+static void
+kasasa_frame_source_class_init (KasasaFrameSourceClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->dispose = kasasa_frame_source_dispose;
+  object_class->finalize = kasasa_frame_source_finalize;
+}
+
+static void
+kasasa_frame_source_init (KasasaFrameSource *self)
+{
+  self->pending_grabs = g_ptr_array_new_with_free_func (g_object_unref);
+}
+
+KasasaFrameSource *
+kasasa_frame_source_new (XdpPortal *portal)
+{
+  KasasaFrameSource *self = NULL;
+
+  g_return_val_if_fail (XDP_IS_PORTAL (portal), NULL);
+
+  self = g_object_new (KASASA_TYPE_FRAME_SOURCE, NULL);
+  self->portal = g_object_ref (portal);
+
+  return self;
+}
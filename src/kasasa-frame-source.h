@@ -0,0 +1,55 @@
+/* kasasa-frame-source.h
+ *
+ * Copyright 2026 Kelvin Novais
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gtk/gtk.h>
+#include <gst/gst.h>
+#include <gst/video/video.h>
+#include <libportal/portal.h>
+
+#include "kasasa-texture-region.h"
+
+G_BEGIN_DECLS
+
+#define KASASA_TYPE_FRAME_SOURCE (kasasa_frame_source_get_type ())
+
+G_DECLARE_FINAL_TYPE (KasasaFrameSource, kasasa_frame_source, KASASA, FRAME_SOURCE, GObject)
+
+KasasaFrameSource *kasasa_frame_source_new (XdpPortal *portal);
+void kasasa_frame_source_grab_async (KasasaFrameSource   *frame_source,
+                                     XdpParent           *parent,
+                                     GAsyncReadyCallback  callback,
+                                     gpointer             user_data);
+KasasaTextureRegion *kasasa_frame_source_grab_finish (KasasaFrameSource  *frame_source,
+                                                      GAsyncResult       *result,
+                                                      GError            **error);
+
+gboolean kasasa_frame_info_from_caps (GstCaps      *caps,
+                                      GstVideoInfo *info);
+gboolean kasasa_frame_get_content_bounds (GstSample       *sample,
+                                          graphene_rect_t *bounds);
+GdkTexture *kasasa_frame_texture_new (GstSample             *sample,
+                                      const graphene_rect_t *crop);
+guint8 *kasasa_frame_get_signature (GstSample             *sample,
+                                    const graphene_rect_t *crop,
+                                    guint                  grid_size);
+
+G_END_DECLS
@@ -0,0 +1,218 @@
+/* kasasa-memory-budget.c
+ *
+ * Copyright 2026 Kelvin Novais
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "kasasa-memory-budget.h"
+#include "kasasa-settings.h"
+
+/*
+ * KasasaMemoryBudget accounts the memory of the contents of all windows. When
+ * the sum goes over the "memory-budget-mb" setting, the least recently viewed
+ * contents are degraded first (downscaled), and then trimmed (only the encoded
+ * image is kept). The most recently viewed content is never touched, and
+ * neither are contents that are on screen: nothing would restore them while
+ * they're shown, even once the usage is back under the budget.
+ */
+
+struct _KasasaMemoryBudget
+{
+  GObject                  parent_instance;
+
+  /* Instance variables */
+  KasasaSettings          *settings;
+  // Registered contents (not referenced), from the least to the most recently
+  // viewed
+  GQueue                   contents;
+  guint                    check_source;
+};
+
+G_DEFINE_FINAL_TYPE (KasasaMemoryBudget, kasasa_memory_budget, G_TYPE_OBJECT)
+
+gsize
+kasasa_memory_budget_get_usage (KasasaMemoryBudget *self)
+{
+  gsize usage = 0;
+
+  g_return_val_if_fail (KASASA_IS_MEMORY_BUDGET (self), 0);
+
+  for (GList *link = self->contents.head; link != NULL; link = link->next)
+    usage += kasasa_content_get_memory_usage (KASASA_CONTENT (link->data));
+
+  return usage;
+}
+
+// Trim the least recently viewed contents until the usage fits the budget;
+// returns the usage after trimming
+static gsize
+trim_contents (KasasaMemoryBudget *self,
+               ContentTrimLevel    level,
+               gsize               usage,
+               gsize               budget)
+{
+  for (GList *link = self->contents.head;
+       link != NULL && link != self->contents.tail && usage > budget;
+       link = link->next)
+    {
+      KasasaContent *content = KASASA_CONTENT (link->data);
+      gsize before, after;
+
+      // Contents are only resumed when their page is shown again
+      if (gtk_widget_get_mapped (GTK_WIDGET (content)))
+        continue;
+
+      before = kasasa_content_get_memory_usage (content);
+      kasasa_content_trim_memory (content, level);
+      after = kasasa_content_get_memory_usage (content);
+
+      usage -= before - MIN (before, after);
+    }
+
+  return usage;
+}
+
+static gboolean
+check_budget (gpointer user_data)
+{
+  KasasaMemoryBudget *self = KASASA_MEMORY_BUDGET (user_data);
+  gsize budget, usage;
+
+  self->check_source = 0;
+
+  budget = (gsize) kasasa_settings_get_values (self->settings)->memory_budget_mb
+           * 1024 * 1024;
+  usage = kasasa_memory_budget_get_usage (self);
+
+  g_debug ("Memory usage: %" G_GSIZE_FORMAT " of %" G_GSIZE_FORMAT " bytes",
+           usage, budget);
+
+  if (usage <= budget)
+    return G_SOURCE_REMOVE;
+
+  usage = trim_contents (self, CONTENT_TRIM_LEVEL_DEGRADE, usage, budget);
+  usage = trim_contents (self, CONTENT_TRIM_LEVEL_COMPLETE, usage, budget);
+
+  if (usage > budget)
+    g_debug ("Memory budget still exceeded after trimming: %" G_GSIZE_FORMAT " bytes",
+             usage);
+
+  return G_SOURCE_REMOVE;
+}
+
+// Check the budget once the current main loop iteration is done, so multiple
+// changes are checked together
+void
+kasasa_memory_budget_queue_check (KasasaMemoryBudget *self)
+{
+  g_return_if_fail (KASASA_IS_MEMORY_BUDGET (self));
+
+  if (self->check_source == 0)
+    self->check_source = g_idle_add (check_budget, self);
+}
+
+void
+kasasa_memory_budget_register (KasasaMemoryBudget *self,
+                               KasasaContent      *content)
+{
+  g_return_if_fail (KASASA_IS_MEMORY_BUDGET (self));
+  g_return_if_fail (KASASA_IS_CONTENT (content));
+
+  // New contents are at the least recently viewed end until they're shown
+  if (g_queue_find (&self->contents, content) == NULL)
+    g_queue_push_head (&self->contents, content);
+}
+
+void
+kasasa_memory_budget_unregister (KasasaMemoryBudget *self,
+                                 KasasaContent      *content)
+{
+  g_return_if_fail (KASASA_IS_MEMORY_BUDGET (self));
+
+  g_queue_remove (&self->contents, content);
+}
+
+// Mark the content as the most recently viewed one
+void
+kasasa_memory_budget_touch (KasasaMemoryBudget *self,
+                            KasasaContent      *content)
+{
+  GList *link = NULL;
+
+  g_return_if_fail (KASASA_IS_MEMORY_BUDGET (self));
+
+  link = g_queue_find (&self->contents, content);
+  if (link == NULL || link == self->contents.tail)
+    return;
+
+  g_queue_unlink (&self->contents, link);
+  g_queue_push_tail_link (&self->contents, link);
+
+  kasasa_memory_budget_queue_check (self);
+}
+
+static void
+on_memory_budget_changed (KasasaSettings *settings,
+                          const gchar    *key,
+                          gpointer        user_data)
+{
+  kasasa_memory_budget_queue_check (KASASA_MEMORY_BUDGET (user_data));
+}
+
+// Returns the instance shared by all windows; it lives until the app exits
+KasasaMemoryBudget *
+kasasa_memory_budget_get_default (void)
+{
+  static KasasaMemoryBudget *default_budget = NULL;
+
+  if (default_budget == NULL)
+    default_budget = g_object_new (KASASA_TYPE_MEMORY_BUDGET, NULL);
+
+  return default_budget;
+}
+
+static void
+kasasa_memory_budget_dispose (GObject *object)
+{
+  KasasaMemoryBudget *self = KASASA_MEMORY_BUDGET (object);
+
+  g_clear_handle_id (&self->check_source, g_source_remove);
+  g_queue_clear (&self->contents);
+  if (self->settings != NULL)
+    g_signal_handlers_disconnect_by_data (self->settings, self);
+  g_clear_object (&self->settings);
+
+  G_OBJECT_CLASS (kasasa_memory_budget_parent_class)->dispose (object);
+}
+
+static void
+kasasa_memory_budget_class_init (KasasaMemoryBudgetClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->dispose = kasasa_memory_budget_dispose;
+}
+
+static void
+kasasa_memory_budget_init (KasasaMemoryBudget *self)
+{
+  g_queue_init (&self->contents);
+  self->settings = g_object_ref (kasasa_settings_get_default ());
+
+  g_signal_connect (self->settings, "changed::memory-budget-mb",
+                    G_CALLBACK (on_memory_budget_changed), self);
+}
@@ -0,0 +1,43 @@
+/* kasasa-memory-budget.h
+ *
+ * Copyright 2026 Kelvin Novais
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gtk/gtk.h>
+
+#include "kasasa-content.h"
+
+G_BEGIN_DECLS
+
+#define KASASA_TYPE_MEMORY_BUDGET (kasasa_memory_budget_get_type ())
+
+G_DECLARE_FINAL_TYPE (KasasaMemoryBudget, kasasa_memory_budget, KASASA, MEMORY_BUDGET, GObject)
+
+KasasaMemoryBudget *kasasa_memory_budget_get_default (void);
+void kasasa_memory_budget_register (KasasaMemoryBudget *budget,
+                                    KasasaContent      *content);
+void kasasa_memory_budget_unregister (KasasaMemoryBudget *budget,
+                                      KasasaContent      *content);
+void kasasa_memory_budget_touch (KasasaMemoryBudget *budget,
+                                 KasasaContent      *content);
+void kasasa_memory_budget_queue_check (KasasaMemoryBudget *budget);
+gsize kasasa_memory_budget_get_usage (KasasaMemoryBudget *budget);
+
+G_END_DECLS
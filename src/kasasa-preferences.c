@@ -19,6 +19,7 @@
  */
 
 #include "kasasa-preferences.h"
+#include "kasasa-settings.h"
 
 struct _KasasaPreferences
 {
@@ -40,9 +41,16 @@ struct _KasasaPreferences
 
   GtkWidget             *screenshot_delay_adjustment;
 
+  GtkWidget             *memory_budget_adjustment;
+
+  GtkWidget             *fast_retake_switch;
+
+  GtkWidget             *pipeline_profile_row;
+
   GtkWidget             *auto_trash_image_switch;
 
   /* Instance variables */
+  KasasaSettings        *kasasa_settings;
   GSettings             *settings;
 };
 
@@ -78,12 +86,25 @@ on_miniaturize_switch_changed (GObject    *object,
   g_settings_set_boolean (self->settings, "miniaturize-window", miniaturize);
 }
 
+static void
+on_pipeline_profile_row_changed (GObject    *object,
+                                 GParamSpec *pspec,
+                                 gpointer    user_data)
+{
+  KasasaPreferences *self = KASASA_PREFERENCES (user_data);
+
+  // The rows are in the same order as the values of the GSchema enum
+  g_settings_set_enum (self->settings, "pipeline-profile",
+                       adw_combo_row_get_selected (ADW_COMBO_ROW (self->pipeline_profile_row)));
+}
+
 static void
 kasasa_preferences_dispose (GObject *kasasa_preferences)
 {
   KasasaPreferences *self = KASASA_PREFERENCES (kasasa_preferences);
 
   g_clear_object (&self->settings);
+  g_clear_object (&self->kasasa_settings);
 
   gtk_widget_dispose_template (GTK_WIDGET (kasasa_preferences), KASASA_TYPE_PREFERENCES);
 
@@ -115,6 +136,12 @@ kasasa_preferences_class_init (KasasaPreferencesClass *klass)
 
   gtk_widget_class_bind_template_child (widget_class, KasasaPreferences, screenshot_delay_adjustment);
 
+  gtk_widget_class_bind_template_child (widget_class, KasasaPreferences, memory_budget_adjustment);
+
+  gtk_widget_class_bind_template_child (widget_class, KasasaPreferences, fast_retake_switch);
+
+  gtk_widget_class_bind_template_child (widget_class, KasasaPreferences, pipeline_profile_row);
+
   gtk_widget_class_bind_template_child (widget_class, KasasaPreferences, auto_trash_image_switch);
 }
 
@@ -124,7 +151,9 @@ kasasa_preferences_init (KasasaPreferences *self)
 {
   gtk_widget_init_template (GTK_WIDGET (self));
 
-  self->settings = g_settings_new ("io.github.kelvinnovais.Kasasa");
+  // Share the settings with the windows
+  self->kasasa_settings = g_object_ref (kasasa_settings_get_default ());
+  self->settings = g_object_ref (kasasa_settings_get_gsettings (self->kasasa_settings));
 
   // BIND SETTINGS
   // Opacity
@@ -158,24 +187,37 @@ kasasa_preferences_init (KasasaPreferences *self)
                    self->screenshot_delay_adjustment, "value",
                    G_SETTINGS_BIND_DEFAULT);
 
+  // Memory budget
+  g_settings_bind (self->settings, "memory-budget-mb",
+                   self->memory_budget_adjustment, "value",
+                   G_SETTINGS_BIND_DEFAULT);
+
+  // Fast retake
+  g_settings_bind (self->settings, "fast-retake",
+                   self->fast_retake_switch, "active",
+                   G_SETTINGS_BIND_DEFAULT);
+
   // Auto trash image
   g_settings_bind (self->settings, "auto-trash-image",
                    self->auto_trash_image_switch, "active",
                    G_SETTINGS_BIND_DEFAULT);
 
   // MANUAL "BIDING"
-  if (g_settings_get_boolean (self->settings, "change-opacity"))
+  if (kasasa_settings_get_values (self->kasasa_settings)->change_opacity)
     {
       gtk_widget_set_sensitive (self->miniaturize_switch, FALSE);
       adw_expander_row_set_enable_expansion (ADW_EXPANDER_ROW (self->opacity_expander_row),
                                              TRUE);
     }
-  else if (g_settings_get_boolean (self->settings, "miniaturize-window"))
+  else if (kasasa_settings_get_values (self->kasasa_settings)->miniaturize_window)
     {
       gtk_widget_set_sensitive (self->opacity_expander_row, FALSE);
       adw_switch_row_set_active (ADW_SWITCH_ROW (self->miniaturize_switch), TRUE);
     }
 
+  adw_combo_row_set_selected (ADW_COMBO_ROW (self->pipeline_profile_row),
+                              kasasa_settings_get_values (self->kasasa_settings)->pipeline_profile);
+
   // Signals
   g_signal_connect (self->opacity_expander_row, "notify::expanded",
                     G_CALLBACK (on_opacity_expander_row_changed),
@@ -184,6 +226,10 @@ kasasa_preferences_init (KasasaPreferences *self)
   g_signal_connect (self->miniaturize_switch, "notify::active",
                     G_CALLBACK (on_miniaturize_switch_changed),
                     self);
+
+  g_signal_connect (self->pipeline_profile_row, "notify::selected",
+                    G_CALLBACK (on_pipeline_profile_row_changed),
+                    self);
 }
 
 KasasaPreferences *
@@ -0,0 +1,436 @@
+/* kasasa-region-selector.c
+ *
+ * Copyright 2026 Kelvin Novais
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <glib/gi18n.h>
+
+#include "kasasa-region-selector.h"
+
+/*
+ * KasasaRegionSelector shows a capture on a fullscreen window, where the user
+ * drags rectangles over the regions to pin. The "regions-selected" signal is
+ * emitted once, with the selected regions in texture pixels (the array is
+ * empty if the selection was cancelled).
+ */
+
+// Smaller selections are considered accidental clicks (in texture pixels)
+#define MIN_REGION_SIZE 8
+
+// Signals
+enum
+{
+  SIGNAL_REGIONS_SELECTED,
+
+  N_SIGNALS
+};
+
+static guint obj_signals[N_SIGNALS];
+
+struct _KasasaRegionSelector
+{
+  AdwWindow                parent_instance;
+  GtkPicture              *picture;
+  GtkDrawingArea          *drawing_area;
+  GtkButton               *pin_button;
+
+  /* Instance variables */
+  GdkTexture              *texture;
+  // graphene_rect_t, in texture pixels
+  GArray                  *regions;
+  gboolean                 dragging;
+  graphene_rect_t          drag_region;
+  gboolean                 done;
+};
+
+G_DEFINE_FINAL_TYPE (KasasaRegionSelector, kasasa_region_selector, ADW_TYPE_WINDOW)
+
+GdkTexture *
+kasasa_region_selector_get_texture (KasasaRegionSelector *self)
+{
+  g_return_val_if_fail (KASASA_IS_REGION_SELECTOR (self), NULL);
+
+  return self->texture;
+}
+
+// Get how the texture is placed on the picture (content-fit "contain")
+static void
+get_texture_transform (KasasaRegionSelector *self,
+                       gdouble              *scale,
+                       gdouble              *offset_x,
+                       gdouble              *offset_y)
+{
+  gdouble width = gtk_widget_get_width (GTK_WIDGET (self->drawing_area));
+  gdouble height = gtk_widget_get_height (GTK_WIDGET (self->drawing_area));
+  gdouble texture_width = gdk_texture_get_width (self->texture);
+  gdouble texture_height = gdk_texture_get_height (self->texture);
+
+  *scale = MIN (width / texture_width, height / texture_height);
+  *offset_x = (width - texture_width * *scale) / 2;
+  *offset_y = (height - texture_height * *scale) / 2;
+}
+
+// Convert a region in widget coordinates to texture pixels, and vice versa
+static void
+widget_to_texture (KasasaRegionSelector  *self,
+                   const graphene_rect_t *widget_region,
+                   graphene_rect_t       *texture_region)
+{
+  gdouble scale, offset_x, offset_y;
+
+  get_texture_transform (self, &scale, &offset_x, &offset_y);
+
+  graphene_rect_init (texture_region,
+                      (widget_region->origin.x - offset_x) / scale,
+                      (widget_region->origin.y - offset_y) / scale,
+                      widget_region->size.width / scale,
+                      widget_region->size.height / scale);
+}
+
+static void
+texture_to_widget (KasasaRegionSelector  *self,
+                   const graphene_rect_t *texture_region,
+                   graphene_rect_t       *widget_region)
+{
+  gdouble scale, offset_x, offset_y;
+
+  get_texture_transform (self, &scale, &offset_x, &offset_y);
+
+  graphene_rect_init (widget_region,
+                      texture_region->origin.x * scale + offset_x,
+                      texture_region->origin.y * scale + offset_y,
+                      texture_region->size.width * scale,
+                      texture_region->size.height * scale);
+}
+
+static void
+draw_regions (GtkDrawingArea *drawing_area,
+              cairo_t        *cr,
+              gint            width,
+              gint            height,
+              gpointer        user_data)
+{
+  KasasaRegionSelector *self = KASASA_REGION_SELECTOR (user_data);
+  guint n_regions = self->regions->len + (self->dragging ? 1 : 0);
+  graphene_rect_t rect;
+
+  // Dim everything out of the selected regions...
+  cairo_set_fill_rule (cr, CAIRO_FILL_RULE_EVEN_ODD);
+  cairo_set_source_rgba (cr, 0, 0, 0, 0.5);
+  cairo_rectangle (cr, 0, 0, width, height);
+  for (guint i = 0; i < n_regions; i++)
+    {
+      if (i < self->regions->len)
+        texture_to_widget (self, &g_array_index (self->regions, graphene_rect_t, i), &rect);
+      else
+        texture_to_widget (self, &self->drag_region, &rect);
+
+      cairo_rectangle (cr, rect.origin.x, rect.origin.y, rect.size.width, rect.size.height);
+    }
+  cairo_fill (cr);
+
+  // ...and outline them
+  cairo_set_source_rgba (cr, 1, 1, 1, 0.9);
+  cairo_set_line_width (cr, 2);
+  for (guint i = 0; i < n_regions; i++)
+    {
+      if (i < self->regions->len)
+        texture_to_widget (self, &g_array_index (self->regions, graphene_rect_t, i), &rect);
+      else
+        texture_to_widget (self, &self->drag_region, &rect);
+
+      cairo_rectangle (cr, rect.origin.x, rect.origin.y, rect.size.width, rect.size.height);
+      cairo_stroke (cr);
+    }
+}
+
+static void
+update_drag_region (KasasaRegionSelector *self,
+                    gdouble               start_x,
+                    gdouble               start_y,
+                    gdouble               offset_x,
+                    gdouble               offset_y)
+{
+  graphene_rect_t widget_region;
+
+  // The offset can be negative; normalize the rectangle
+  graphene_rect_init (&widget_region, start_x, start_y, offset_x, offset_y);
+  graphene_rect_normalize (&widget_region);
+
+  widget_to_texture (self, &widget_region, &self->drag_region);
+}
+
+static void
+on_drag_begin (GtkGestureDrag *gesture,
+               gdouble         start_x,
+               gdouble         start_y,
+               gpointer        user_data)
+{
+  KasasaRegionSelector *self = KASASA_REGION_SELECTOR (user_data);
+
+  self->dragging = TRUE;
+  update_drag_region (self, start_x, start_y, 0, 0);
+}
+
+static void
+on_drag_update (GtkGestureDrag *gesture,
+                gdouble         offset_x,
+                gdouble         offset_y,
+                gpointer        user_data)
+{
+  KasasaRegionSelector *self = KASASA_REGION_SELECTOR (user_data);
+  gdouble start_x, start_y;
+
+  gtk_gesture_drag_get_start_point (gesture, &start_x, &start_y);
+  update_drag_region (self, start_x, start_y, offset_x, offset_y);
+
+  gtk_widget_queue_draw (GTK_WIDGET (self->drawing_area));
+}
+
+static void
+on_drag_end (GtkGestureDrag *gesture,
+             gdouble         offset_x,
+             gdouble         offset_y,
+             gpointer        user_data)
+{
+  KasasaRegionSelector *self = KASASA_REGION_SELECTOR (user_data);
+  graphene_rect_t bounds;
+  gdouble start_x, start_y;
+
+  self->dragging = FALSE;
+
+  gtk_gesture_drag_get_start_point (gesture, &start_x, &start_y);
+  update_drag_region (self, start_x, start_y, offset_x, offset_y);
+
+  // Keep only the part of the region inside the capture
+  graphene_rect_init (&bounds, 0, 0,
+                      gdk_texture_get_width (self->texture),
+                      gdk_texture_get_height (self->texture));
+
+  if (graphene_rect_intersection (&self->drag_region, &bounds, &self->drag_region)
+      && self->drag_region.size.width >= MIN_REGION_SIZE
+      && self->drag_region.size.height >= MIN_REGION_SIZE)
+    g_array_append_val (self->regions, self->drag_region);
+
+  gtk_widget_set_sensitive (GTK_WIDGET (self->pin_button), self->regions->len > 0);
+  gtk_widget_queue_draw (GTK_WIDGET (self->drawing_area));
+}
+
+// Emit the selected regions (none if cancelled) and close the window
+static void
+finish_selection (KasasaRegionSelector *self,
+                  gboolean              cancelled)
+{
+  g_autoptr (GArray) regions = NULL;
+
+  if (self->done)
+    return;
+
+  self->done = TRUE;
+
+  if (cancelled)
+    g_array_set_size (self->regions, 0);
+
+  regions = g_array_ref (self->regions);
+  g_signal_emit (self, obj_signals[SIGNAL_REGIONS_SELECTED], 0, regions);
+
+  gtk_window_destroy (GTK_WINDOW (self));
+}
+
+static void
+on_pin_button_clicked (GtkButton *button,
+                       gpointer   user_data)
+{
+  finish_selection (KASASA_REGION_SELECTOR (user_data), FALSE);
+}
+
+static void
+on_cancel_button_clicked (GtkButton *button,
+                          gpointer   user_data)
+{
+  finish_selection (KASASA_REGION_SELECTOR (user_data), TRUE);
+}
+
+static gboolean
+on_key_pressed (GtkEventControllerKey *controller,
+                guint                  keyval,
+                guint                  keycode,
+                GdkModifierType        state,
+                gpointer               user_data)
+{
+  KasasaRegionSelector *self = KASASA_REGION_SELECTOR (user_data);
+
+  if (keyval == GDK_KEY_Escape)
+    {
+      finish_selection (self, TRUE);
+      return GDK_EVENT_STOP;
+    }
+  else if ((keyval == GDK_KEY_Return || keyval == GDK_KEY_KP_Enter)
+           && self->regions->len > 0)
+    {
+      finish_selection (self, FALSE);
+      return GDK_EVENT_STOP;
+    }
+  else if (keyval == GDK_KEY_BackSpace && self->regions->len > 0)
+    {
+      // Undo the last selection
+      g_array_set_size (self->regions, self->regions->len - 1);
+      gtk_widget_set_sensitive (GTK_WIDGET (self->pin_button), self->regions->len > 0);
+      gtk_widget_queue_draw (GTK_WIDGET (self->drawing_area));
+      return GDK_EVENT_STOP;
+    }
+
+  return GDK_EVENT_PROPAGATE;
+}
+
+static gboolean
+on_close_request (GtkWindow *window,
+                  gpointer   user_data)
+{
+  KasasaRegionSelector *self = KASASA_REGION_SELECTOR (window);
+
+  // Closed by the window manager
+  if (!self->done)
+    {
+      self->done = TRUE;
+      g_array_set_size (self->regions, 0);
+      g_signal_emit (self, obj_signals[SIGNAL_REGIONS_SELECTED], 0, self->regions);
+    }
+
+  return FALSE;
+}
+
+static void
+kasasa_region_selector_dispose (GObject *object)
+{
+  KasasaRegionSelector *self = KASASA_REGION_SELECTOR (object);
+
+  g_clear_object (&self->texture);
+  g_clear_pointer (&self->regions, g_array_unref);
+
+  G_OBJECT_CLASS (kasasa_region_selector_parent_class)->dispose (object);
+}
+
+static void
+kasasa_region_selector_class_init (KasasaRegionSelectorClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  // Signals
+  obj_signals[SIGNAL_REGIONS_SELECTED] =
+    g_signal_new ("regions-selected",
+                  KASASA_TYPE_REGION_SELECTOR,
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL, NULL,
+                  NULL,
+                  G_TYPE_NONE,            // no return value
+                  1,                      // 1 argument
+                  G_TYPE_ARRAY);          // regions (graphene_rect_t)
+
+  object_class->dispose = kasasa_region_selector_dispose;
+}
+
+static void
+kasasa_region_selector_init (KasasaRegionSelector *self)
+{
+  GtkWidget *overlay = NULL;
+  GtkWidget *box = NULL;
+  GtkWidget *label = NULL;
+  GtkWidget *cancel_button = NULL;
+  GtkGesture *drag_gesture = NULL;
+  GtkEventController *key_controller = NULL;
+
+  self->regions = g_array_new (FALSE, FALSE, sizeof (graphene_rect_t));
+
+  overlay = gtk_overlay_new ();
+
+  // Capture
+  self->picture = GTK_PICTURE (gtk_picture_new ());
+  gtk_picture_set_content_fit (self->picture, GTK_CONTENT_FIT_CONTAIN);
+  gtk_overlay_set_child (GTK_OVERLAY (overlay), GTK_WIDGET (self->picture));
+
+  // Selections
+  self->drawing_area = GTK_DRAWING_AREA (gtk_drawing_area_new ());
+  gtk_drawing_area_set_draw_func (self->drawing_area, draw_regions, self, NULL);
+  gtk_widget_set_cursor_from_name (GTK_WIDGET (self->drawing_area), "crosshair");
+  gtk_overlay_add_overlay (GTK_OVERLAY (overlay), GTK_WIDGET (self->drawing_area));
+
+  // Controls
+  box = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 6);
+  gtk_widget_add_css_class (box, "osd-box");
+  gtk_widget_set_halign (box, GTK_ALIGN_CENTER);
+  gtk_widget_set_valign (box, GTK_ALIGN_END);
+  gtk_widget_set_margin_bottom (box, 18);
+
+  label = gtk_label_new (_("Drag to select the regions to pin"));
+  gtk_widget_set_margin_start (label, 12);
+  gtk_widget_set_margin_end (label, 6);
+  gtk_box_append (GTK_BOX (box), label);
+
+  cancel_button = gtk_button_new_with_label (_("Cancel"));
+  gtk_widget_add_css_class (cancel_button, "flat");
+  gtk_box_append (GTK_BOX (box), cancel_button);
+
+  self->pin_button = GTK_BUTTON (gtk_button_new_with_label (_("Pin")));
+  gtk_widget_add_css_class (GTK_WIDGET (self->pin_button), "suggested-action");
+  gtk_widget_set_sensitive (GTK_WIDGET (self->pin_button), FALSE);
+  gtk_box_append (GTK_BOX (box), GTK_WIDGET (self->pin_button));
+
+  gtk_overlay_add_overlay (GTK_OVERLAY (overlay), box);
+
+  adw_window_set_content (ADW_WINDOW (self), overlay);
+
+  // Signals
+  g_signal_connect (cancel_button, "clicked",
+                    G_CALLBACK (on_cancel_button_clicked), self);
+  g_signal_connect (self->pin_button, "clicked",
+                    G_CALLBACK (on_pin_button_clicked), self);
+  g_signal_connect (self, "close-request",
+                    G_CALLBACK (on_close_request), NULL);
+
+  // Event controllers
+  drag_gesture = gtk_gesture_drag_new ();
+  g_signal_connect (drag_gesture, "drag-begin",
+                    G_CALLBACK (on_drag_begin), self);
+  g_signal_connect (drag_gesture, "drag-update",
+                    G_CALLBACK (on_drag_update), self);
+  g_signal_connect (drag_gesture, "drag-end",
+                    G_CALLBACK (on_drag_end), self);
+  gtk_widget_add_controller (GTK_WIDGET (self->drawing_area),
+                             GTK_EVENT_CONTROLLER (drag_gesture));
+
+  key_controller = gtk_event_controller_key_new ();
+  g_signal_connect (key_controller, "key-pressed",
+                    G_CALLBACK (on_key_pressed), self);
+  gtk_widget_add_controller (GTK_WIDGET (self), key_controller);
+}
+
+KasasaRegionSelector *
+kasasa_region_selector_new (GdkTexture *texture)
+{
+  KasasaRegionSelector *self = NULL;
+
+  g_return_val_if_fail (GDK_IS_TEXTURE (texture), NULL);
+
+  self = g_object_new (KASASA_TYPE_REGION_SELECTOR, NULL);
+  self->texture = g_object_ref (texture);
+  gtk_picture_set_paintable (self->picture, GDK_PAINTABLE (texture));
+
+  return self;
+}
@@ -0,0 +1,34 @@
+/* kasasa-region-selector.h
+ *
+ * Copyright 2026 Kelvin Novais
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <adwaita.h>
+
+G_BEGIN_DECLS
+
+#define KASASA_TYPE_REGION_SELECTOR (kasasa_region_selector_get_type ())
+
+G_DECLARE_FINAL_TYPE (KasasaRegionSelector, kasasa_region_selector, KASASA, REGION_SELECTOR, AdwWindow)
+
+KasasaRegionSelector *kasasa_region_selector_new (GdkTexture *texture);
+GdkTexture *kasasa_region_selector_get_texture (KasasaRegionSelector *selector);
+
+G_END_DECLS
@@ -19,13 +19,51 @@
  */
 
 #include <gst/gst.h>
+#include <gst/video/video.h>
 #include <glib/gi18n.h>
+#include <string.h>
 
 #include "kasasa-screencast.h"
+#include "kasasa-memory-budget.h"
+#include "kasasa-frame-source.h"
+#include "kasasa-stream.h"
+#include "kasasa-settings.h"
 
 #define CROP_CHEK_INTERVAL 5              // seconds
 #define FIRST_CROP_CHECK_INTERVAL 200     // miliseconds
 
+// Watch mode: a WATCH_GRID_SIZE x WATCH_GRID_SIZE signature of a frame taken
+// every WATCH_INTERVAL is compared with the reference one; the frame changed if
+// at least WATCH_N_CHANGED_BLOCKS blocks differ by more than
+// WATCH_BLOCK_THRESHOLD. Without a new frame after WATCH_FRAME_TIMEOUT, the
+// window didn't change
+#define WATCH_INTERVAL 2                  // seconds
+#define WATCH_FRAME_TIMEOUT 500           // miliseconds
+#define WATCH_GRID_SIZE 16
+#define WATCH_BLOCK_THRESHOLD 12          // luma levels
+#define WATCH_N_CHANGED_BLOCKS 3
+
+// Frame requests without a last sample wait this long for a new frame
+#define FRAME_REQUEST_TIMEOUT 1000        // miliseconds
+
+// Linear BGRx dmabufs, which gtk4paintablesink imports as dmabuf textures and
+// which can still be mapped to read the frames
+#define DMABUF_CAPS "video/x-raw(memory:DMABuf), format = (string) DMA_DRM, drm-format = (string) XR24"
+
+// Formats that gtk4paintablesink uploads as memory textures as they are, so
+// that videoconvert runs in passthrough for the usual PipeWire formats
+#define MEMORY_TEXTURE_CAPS "video/x-raw, format = (string) { BGRx, BGRA, RGBx, RGBA, xRGB, ARGB, xBGR, ABGR }"
+
+// Frames let through may still be dropped by the leaky queue or by the sink, so
+// a frame is let through at least this often, even if identical
+#define FRAME_REVALIDATE_INTERVAL (GST_SECOND)
+
+// Live miniature: frames per second of the downscaled thumbnail branch
+#define THUMBNAIL_FRAME_RATE 2
+
+// Low power profile: frames per second shown at most
+#define LOW_POWER_FRAME_RATE 10
+
 // Default dimensions
 #define DEFAULT_WIDTH  360
 #define DEFAULT_HEIGHT 200
@@ -53,26 +91,105 @@ enum
 {
   SIGNAL_NEW_DIMENSION,
   SIGNAL_EOS,
+  SIGNAL_CHANGED,
+  SIGNAL_RECONNECT,
 
   N_SIGNALS
 };
 
 static guint obj_signals[N_SIGNALS];
 
+// GStreamer is initialized lazily: loading the plugin registry is expensive and
+// most windows never start a screencast
+static GMutex gst_init_mutex;
+static GThread *gst_init_thread = NULL;
+static gboolean gst_initialized = FALSE;
+
 struct _KasasaScreencast
 {
   AdwBin                   parent_instance;
   GtkStack                *stack;
   AdwStatusPage           *no_screencast_page;
+  GtkWidget               *reconnect_button;
+  // Holds the picture, so that dmabuf frames can be scanned out as a subsurface
+  GtkWidget               *offload;
   GtkPicture              *picture;
 
   /* Instance variables */
-  GstElement              *pipeline;
-  XdpSession              *session;
-  gulong                   closed_handler_id;
+  // Shared with the other screencasts of the same PipeWire node
+  KasasaStream            *stream;
+  // This screencast's part of the pipeline: queue ! capsfilter ! videocrop ! sink
+  // or, for dmabuf frames, queue ! capsfilter ! sink
+  GstElement              *branch;
+  // Owned by the branch
+  GstElement              *queue;
+  GstElement              *videocrop;
+  GstElement              *sink;
+  // The frames are cropped with a crop meta instead of videocrop, so that
+  // dmabufs reach the sink as they are
+  gboolean                 crop_meta;
   guint                    cropping_source;
+  // Also read from the streaming thread
   gint                     crop[CROP_N_ELEMENTS];
   gint                     dimension[DIMENSION_N_ELEMENTS];
+  // Read from the streaming thread
+  gint                     suspended;
+  gboolean                 trimmed;
+  // A region chosen by the user is shown, instead of the auto cropped window
+  gboolean                 fixed_region;
+  // Watch mode
+  gboolean                 watching;
+  guint                    watch_source;
+  gulong                   watch_probe_id;
+  // Read from the streaming thread
+  gint                     watch_frame_pending;
+  gboolean                 watch_holding_stream;
+  guint                    watch_frame_timeout_source;
+  GCancellable            *watch_cancellable;
+  // Signature of the frame when watching started, or when the last change was
+  // notified
+  guint8                  *watch_signature;
+  // Limit set with kasasa_screencast_set_max_frame_rate () (0 for no limit)
+  guint                    max_frame_rate;
+  // Frame requests waiting for the next frame, as there was no last sample
+  GPtrArray               *frame_tasks;
+  // Read from the streaming thread
+  gint                     frame_request_pending;
+  gulong                   frame_probe_id;
+  gboolean                 frame_holding_stream;
+  guint                    frame_timeout_source;
+  // Minimum time between displayed frames (0 for no limit); read from the
+  // streaming thread
+  gint                     frame_interval_ms;
+  GstClockTime             last_frame_pts;
+  // Comparison with the last displayed frame, only used from the streaming
+  // thread: damage_valid tells if the damage of the next frame is relative to
+  // it (no frame was dropped for another reason in between)
+  GstVideoInfo             frame_info;
+  gboolean                 has_frame_info;
+  gboolean                 frame_is_dmabuf;
+  guint64                  last_frame_checksum;
+  gboolean                 checksum_valid;
+  gboolean                 damage_valid;
+  GstClockTime             last_shown_pts;
+  // Lets the next frame through (e.g. after the crop changed)
+  gint                     reset_checksum;
+  // Whether the screencast asked the stream to play
+  gboolean                 holding_stream;
+  // Live snapshot mode: seconds between refreshes (0 for a live screencast)
+  // and whether a frame should be shown; read from the streaming thread
+  gint                     refresh_interval;
+  gint                     snapshot_pending;
+  guint                    refresh_source;
+  // Live miniature: queue ! videocrop ! videoscale ! capsfilter ! videoconvert
+  // ! sink, while the full resolution branch is suspended
+  GstElement              *thumbnail_branch;
+  GstElement              *thumbnail_videocrop;
+  GstElement              *thumbnail_filter;
+  gint                     thumbnail_size;
+  gboolean                 thumbnail_suspended;
+  // Only used from the streaming thread
+  GstClockTime             last_thumbnail_pts;
 };
 
 static void kasasa_screencast_content_interface_init (KasasaContentInterface *iface);
@@ -81,6 +198,8 @@ G_DEFINE_TYPE_WITH_CODE (KasasaScreencast, kasasa_screencast, ADW_TYPE_BIN,
                          G_IMPLEMENT_INTERFACE (KASASA_TYPE_CONTENT,
                                                 kasasa_screencast_content_interface_init))
 
+static void detach_stream (KasasaScreencast *self);
+
 static void
 kasasa_screencast_get_dimensions (KasasaContent *content,
                                   gint          *height,
@@ -101,6 +220,7 @@ set_no_screencast (KasasaScreencast *self)
   self->dimension[DIMENSION_WIDTH] = DEFAULT_WIDTH;
   self->dimension[DIMENSION_HEIGHT] = DEFAULT_HEIGHT;
 
+  gtk_widget_set_visible (self->reconnect_button, FALSE);
   gtk_stack_set_visible_child (self->stack, GTK_WIDGET (self->no_screencast_page));
 }
 
@@ -114,363 +234,1817 @@ kasasa_screencast_finish (KasasaContent *content)
   self = KASASA_SCREENCAST (content);
 
   set_no_screencast (self);
-
-  if (self->pipeline)
-    gst_element_set_state (self->pipeline, GST_STATE_READY);
+  detach_stream (self);
 }
 
-static void
-on_session_closed (XdpSession *session,
-                   gpointer    user_data)
+static gboolean
+is_running (KasasaScreencast *self)
 {
-  g_info ("Session closed");
-  g_signal_emit (user_data,
-                 obj_signals[SIGNAL_EOS],
-                 0);
+  return self->stream != NULL
+         && gtk_stack_get_visible_child (self->stack) == self->offload;
 }
 
-static void
-eos_cb (GstBus           *bus,
-        GstMessage       *msg,
-        KasasaScreencast *self)
+// Whether frames are being shown; FALSE when the stream ended or failed
+gboolean
+kasasa_screencast_is_running (KasasaScreencast *self)
 {
-  g_info ("End-Of-Stream reached");
-  g_signal_emit (self,
-                 obj_signals[SIGNAL_EOS],
-                 0);
+  g_return_val_if_fail (KASASA_IS_SCREENCAST (self), FALSE);
+
+  return is_running (self);
 }
 
+/*
+ * Keep the stream playing while this screencast needs frames: when it's not
+ * suspended and, in live snapshot mode, only until the next frame is shown
+ */
 static void
-error_cb (GstBus           *bus,
-          GstMessage       *msg,
-          KasasaScreencast *self)
+update_stream_hold (KasasaScreencast *self)
 {
-  g_autoptr (GError) error = NULL;
-  g_autofree gchar *debug_info = NULL;
+  gboolean hold;
 
-  gst_message_parse_error (msg, &error, &debug_info);
-  g_warning ("Error received from element %s: %s",
-             GST_OBJECT_NAME (msg->src), error->message);
-  g_warning ("Debugging information: %s", debug_info ? debug_info : "none");
+  hold = self->stream != NULL
+         && !self->suspended
+         && (self->refresh_interval == 0 || g_atomic_int_get (&self->snapshot_pending));
 
-  adw_status_page_set_title (self->no_screencast_page,
-                             _("Screencast ended with error"));
-  set_no_screencast (self);
+  if (hold == self->holding_stream)
+    return;
 
-  gst_element_set_state (self->pipeline, GST_STATE_READY);
+  self->holding_stream = hold;
+  if (hold)
+    kasasa_stream_play (self->stream);
+  else
+    kasasa_stream_pause (self->stream);
 }
 
-static void
-set_crop (KasasaScreencast *self)
+static gboolean
+on_snapshot_shown (gpointer user_data)
 {
-  GstElement *videocrop = gst_bin_get_by_name (GST_BIN (self->pipeline),
-                                               "videocrop");
+  update_stream_hold (KASASA_SCREENCAST (user_data));
+
+  return G_SOURCE_REMOVE;
+}
 
-  if (!videocrop)
+// PipeWire damage regions, attached by pipewiresrc as region of interest metas.
+// Returns FALSE if the buffer carries no damage information; otherwise,
+// changed is set if a damaged region intersects the displayed area
+static gboolean
+get_frame_damage (KasasaScreencast *self,
+                  GstBuffer        *buffer,
+                  gboolean         *changed)
+{
+  GstVideoRegionOfInterestMeta *meta = NULL;
+  gpointer state = NULL;
+  gboolean has_damage = FALSE;
+  gint left = g_atomic_int_get (&self->crop[CROP_LEFT]);
+  gint top = g_atomic_int_get (&self->crop[CROP_TOP]);
+  gint right = GST_VIDEO_INFO_WIDTH (&self->frame_info) - g_atomic_int_get (&self->crop[CROP_RIGHT]);
+  gint bottom = GST_VIDEO_INFO_HEIGHT (&self->frame_info) - g_atomic_int_get (&self->crop[CROP_BOTTOM]);
+
+  *changed = FALSE;
+
+  while ((meta = (GstVideoRegionOfInterestMeta *)
+                 gst_buffer_iterate_meta_filtered (buffer, &state,
+                                                   GST_VIDEO_REGION_OF_INTEREST_META_API_TYPE)))
     {
-      g_warning ("Failed to set video crop");
-      return;
-    }
+      if (meta->roi_type != g_quark_from_static_string ("damage"))
+        continue;
 
-  gst_element_set_state (self->pipeline, GST_STATE_PAUSED);
-  g_object_set (videocrop,
-                "top", self->crop[CROP_TOP],
-                "right", self->crop[CROP_RIGHT],
-                "bottom", self->crop[CROP_BOTTOM],
-                "left", self->crop[CROP_LEFT],
-                NULL);
-  gst_element_set_state (self->pipeline, GST_STATE_PLAYING);
+      has_damage = TRUE;
+
+      if ((gint) meta->x < right && (gint) (meta->x + meta->w) > left
+          && (gint) meta->y < bottom && (gint) (meta->y + meta->h) > top)
+        {
+          *changed = TRUE;
+          break;
+        }
+    }
 
-  gst_object_unref (videocrop);
+  return has_damage;
 }
 
-static void
-new_dimension (KasasaScreencast *self,
-               gint              new_width,
-               gint              new_height)
+// Hash of the displayed area of a packed frame; every byte is read, as a
+// sparse sample would miss small changes, like a typed character, and leave a
+// stale frame on screen
+static gboolean
+get_frame_checksum (KasasaScreencast *self,
+                    GstBuffer        *buffer,
+                    guint64          *checksum)
 {
-  if (self->dimension[DIMENSION_WIDTH] != new_width
-      || self->dimension[DIMENSION_HEIGHT] != new_height)
+  GstVideoFrame frame;
+  guint64 hash = 14695981039346656037ULL;
+  const guint8 *data = NULL;
+  gint pixel_stride, stride;
+  gint left = g_atomic_int_get (&self->crop[CROP_LEFT]);
+  gint top = g_atomic_int_get (&self->crop[CROP_TOP]);
+  gint right = GST_VIDEO_INFO_WIDTH (&self->frame_info) - g_atomic_int_get (&self->crop[CROP_RIGHT]);
+  gint bottom = GST_VIDEO_INFO_HEIGHT (&self->frame_info) - g_atomic_int_get (&self->crop[CROP_BOTTOM]);
+  gsize row_size;
+
+  // Reading a whole dmabuf back from the GPU costs more than showing it
+  if (self->frame_is_dmabuf
+      || GST_VIDEO_INFO_N_PLANES (&self->frame_info) != 1
+      || left < 0 || top < 0 || right <= left || bottom <= top)
+    return FALSE;
+
+  // Plane offsets and strides are taken from the video meta, if any
+  if (!gst_video_frame_map (&frame, &self->frame_info, buffer, GST_MAP_READ))
+    return FALSE;
+
+  pixel_stride = GST_VIDEO_FRAME_COMP_PSTRIDE (&frame, 0);
+  stride = GST_VIDEO_FRAME_PLANE_STRIDE (&frame, 0);
+  data = GST_VIDEO_FRAME_PLANE_DATA (&frame, 0);
+
+  if (pixel_stride <= 0)
     {
-      g_signal_emit (self,
-                     obj_signals[SIGNAL_NEW_DIMENSION],
-                     0,
-                     new_width,
-                     new_height);
+      gst_video_frame_unmap (&frame);
+      return FALSE;
     }
 
-  // We expect a window following the GTK/ADW minimal dimensions
-  self->dimension[DIMENSION_WIDTH] = MAX (new_width, DEFAULT_WIDTH);
-  self->dimension[DIMENSION_HEIGHT] = MAX (new_height, DEFAULT_HEIGHT);
+  row_size = (gsize) (right - left) * pixel_stride;
+
+  for (gint y = top; y < bottom; y++)
+    {
+      const guint8 *row = data + (gsize) y * stride + (gsize) left * pixel_stride;
+      gsize i = 0;
+      guint64 word;
+
+      for (; i + sizeof (word) <= row_size; i += sizeof (word))
+        {
+          memcpy (&word, row + i, sizeof (word));
+          hash = (hash ^ word) * 1099511628211ULL;
+        }
+
+      for (; i < row_size; i++)
+        hash = (hash ^ row[i]) * 1099511628211ULL;
+    }
+
+  gst_video_frame_unmap (&frame);
+
+  *checksum = hash;
+  return TRUE;
 }
 
+// Whether the frame shows the same content as the last displayed one, so that
+// the conversion, upload and redraw can be skipped
 static gboolean
-compute_crop_values (gpointer user_data)
+is_frame_identical (KasasaScreencast *self,
+                    GstBuffer        *buffer)
 {
-  KasasaScreencast *self = NULL;
-  g_autoptr (GstSample) sample = NULL;
-  g_autoptr (GstElement) fakesink = NULL;
-  GstBuffer *buffer = NULL;
-  const GstCaps *caps = NULL;
-  GstMapInfo map;
+  GstClockTime pts = GST_BUFFER_PTS (buffer);
+  gboolean use_damage, changed;
+  guint64 checksum;
 
-  gint width = 0;
-  gint height = 0;
-
-  self = KASASA_SCREENCAST (user_data);
+  if (g_atomic_int_compare_and_exchange (&self->reset_checksum, TRUE, FALSE))
+    {
+      self->checksum_valid = FALSE;
+      self->damage_valid = FALSE;
+    }
 
-  // Get fakesink
-  fakesink = gst_bin_get_by_name (GST_BIN (self->pipeline), "fakesink");
-  if (fakesink == NULL)
+  // The last frame let through may not be the displayed one
+  if (GST_CLOCK_TIME_IS_VALID (pts)
+      && GST_CLOCK_TIME_IS_VALID (self->last_shown_pts)
+      && (pts < self->last_shown_pts
+          || pts - self->last_shown_pts >= FRAME_REVALIDATE_INTERVAL))
     {
-      g_warning ("Got fakesink == NULL while processing crop dimensions. "\
-                 "Unable to crop to window size.");
-      return G_SOURCE_REMOVE;
+      self->checksum_valid = FALSE;
+      self->damage_valid = FALSE;
     }
 
-  // Get sample
-  g_object_get (fakesink,
-                "last-sample", &sample,
-                NULL);
-  if (sample == NULL)
+  if (!self->has_frame_info)
+    return FALSE;
+
+  // The damage of the next frame is relative to this one, which is either let
+  // through or identical to the displayed one
+  use_damage = self->damage_valid;
+  self->damage_valid = TRUE;
+
+  if (use_damage && get_frame_damage (self, buffer, &changed))
     {
-      g_debug ("sample == NULL while processing crop dimensions");
-      return G_SOURCE_CONTINUE;
+      // The checksum is outdated once a changed frame is let through
+      if (changed)
+        self->checksum_valid = FALSE;
+
+      return !changed;
     }
 
-  // Get sample info
-  caps = gst_sample_get_caps (sample);
-  if (caps)
+  if (!get_frame_checksum (self, buffer, &checksum))
     {
-      const GstStructure *structure;
-      const gchar *format;
+      self->checksum_valid = FALSE;
+      return FALSE;
+    }
 
-      structure = gst_caps_get_structure (caps, 0);
-      format = gst_structure_get_string (structure, "format");
+  if (self->checksum_valid && checksum == self->last_frame_checksum)
+    return TRUE;
 
-      // Check if the format is BGRx
-      if (g_strcmp0 (format, "BGRx") == 0)
-        {
-          gst_structure_get_int (structure, "width", &width);
-          gst_structure_get_int (structure, "height", &height);
-        }
-      else
+  self->last_frame_checksum = checksum;
+  self->checksum_valid = TRUE;
+  return FALSE;
+}
+
+// Drop the frames that arrive before the frame interval has passed, and those
+// identical to the displayed frame. The video info is kept from the caps
+// events, so that it isn't queried for each frame
+static GstPadProbeReturn
+throttle_probe_cb (GstPad          *pad,
+                   GstPadProbeInfo *info,
+                   gpointer         user_data)
+{
+  KasasaScreencast *self = KASASA_SCREENCAST (user_data);
+  GstBuffer *buffer = NULL;
+  GstClockTime pts;
+  gint interval_ms = g_atomic_int_get (&self->frame_interval_ms);
+
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM)
+    {
+      GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
+      GstCaps *caps = NULL;
+
+      if (GST_EVENT_TYPE (event) == GST_EVENT_CAPS)
         {
-          g_warning ("Expected format BGRx, but received: %s. "\
-                     "Unable to crop to window size.", format);
-          gst_buffer_unmap (buffer, &map);
-          return G_SOURCE_REMOVE;
+          gst_event_parse_caps (event, &caps);
+          self->has_frame_info = kasasa_frame_info_from_caps (caps, &self->frame_info);
+          self->frame_is_dmabuf = gst_video_is_dma_drm_caps (caps);
+          self->checksum_valid = FALSE;
+          self->damage_valid = FALSE;
         }
+
+      return GST_PAD_PROBE_OK;
     }
 
-  // Ensure the width and height of the sample is ok
-  if (width < 100 || height < 100)
+  buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+  pts = GST_BUFFER_PTS (buffer);
+
+  // The stream may keep flowing for other screencasts. The damage of the
+  // frames dropped from here on is lost, so it can't be trusted for the next
+  // frame
+  if (g_atomic_int_get (&self->suspended))
     {
-      g_warning ("Sample is too small, crop skipped");
-      return G_SOURCE_REMOVE;
+      self->damage_valid = FALSE;
+      return GST_PAD_PROBE_DROP;
     }
 
-  // Get crop dimensions
-  buffer = gst_sample_get_buffer (sample);
-  if (gst_buffer_map (buffer, &map, GST_MAP_READ))
+  // Live snapshot: a single frame is shown on each refresh, then the stream
+  // can be paused
+  if (g_atomic_int_get (&self->refresh_interval) > 0)
     {
-      gint top = height, bottom = 0, left = width, right = 0;
+      // The next live frame isn't compared against the snapshot
+      self->checksum_valid = FALSE;
+      self->damage_valid = FALSE;
 
-      // Analyze the pixel data
-      // (I) Columns
-      for (gint y = 0; y < height; y++)
-        {
-          for (gint x = 0; x < width; x = (x+1)*4)
-            {
-              // 4 bytes per pixel (B, G, R, X)
-              gint index = (y * width + x) * 4;
+      if (!g_atomic_int_compare_and_exchange (&self->snapshot_pending, TRUE, FALSE))
+        return GST_PAD_PROBE_DROP;
 
-              guchar b = map.data[index];
-              guchar g = map.data[index + 1];
-              guchar r = map.data[index + 2];
+      g_main_context_invoke_full (NULL, G_PRIORITY_DEFAULT,
+                                  on_snapshot_shown,
+                                  g_object_ref (self), g_object_unref);
+      return GST_PAD_PROBE_OK;
+    }
 
-              // Check if the pixel is not black (ignoring the alpha channel)
-              if (b != 0 || g != 0 || r != 0)
-                {
-                  if (y < top) top = y;
-                  if (y > bottom) bottom = y;
-                }
-            }
+  if (interval_ms > 0 && GST_CLOCK_TIME_IS_VALID (pts))
+    {
+      if (GST_CLOCK_TIME_IS_VALID (self->last_frame_pts)
+          && pts >= self->last_frame_pts
+          && pts - self->last_frame_pts < (GstClockTime) interval_ms * GST_MSECOND)
+        {
+          self->damage_valid = FALSE;
+          return GST_PAD_PROBE_DROP;
         }
 
-      for (gint y = 0; y < height; y = (y+1)*4)
-        {
-          for (gint x = 0; x < width; x++)
-            {
-              gint index = (y * width + x) * 4;
+      self->last_frame_pts = pts;
+    }
 
-              guchar b = map.data[index];
-              guchar g = map.data[index + 1];
-              guchar r = map.data[index + 2];
+  if (is_frame_identical (self, buffer))
+    return GST_PAD_PROBE_DROP;
 
-              if (b != 0 || g != 0 || r != 0)
-                {
-                  if (x < left) left = x;
-                  if (x > right) right = x;
-                }
-            }
-        }
+  self->last_shown_pts = pts;
+  return GST_PAD_PROBE_OK;
+}
 
-      // Crop values
-      self->crop[CROP_TOP] = top;
-      self->crop[CROP_RIGHT] = width - right;
-      self->crop[CROP_BOTTOM] = height - bottom;
-      self->crop[CROP_LEFT] = left;
+static gboolean
+refresh_snapshot (gpointer user_data)
+{
+  KasasaScreencast *self = KASASA_SCREENCAST (user_data);
 
-      new_dimension (self,
-                     (right - left),          // width
-                     (bottom - top));         // height
+  // Hidden pages are refreshed when resumed
+  if (!self->suspended)
+    {
+      g_atomic_int_set (&self->snapshot_pending, TRUE);
+      update_stream_hold (self);
+    }
 
-      gst_buffer_unmap (buffer, &map);
+  return G_SOURCE_CONTINUE;
+}
+
+/*
+ * Live snapshot mode: show a single frame every refresh_interval seconds and
+ * let the stream idle in between; 0 shows the live screencast
+ */
+void
+kasasa_screencast_set_refresh_interval (KasasaScreencast *self,
+                                        guint             refresh_interval)
+{
+  g_return_if_fail (KASASA_IS_SCREENCAST (self));
+
+  g_clear_handle_id (&self->refresh_source, g_source_remove);
+
+  // There's nothing to refresh once the stream is detached
+  if (self->stream == NULL)
+    {
+      g_atomic_int_set (&self->refresh_interval, 0);
+      return;
     }
 
-  g_debug ("Crop values: top: %d, bottom: %d, left: %d, right: %d",
-           self->crop[CROP_TOP], self->crop[CROP_BOTTOM],
-           self->crop[CROP_LEFT], self->crop[CROP_RIGHT]);
+  g_atomic_int_set (&self->refresh_interval, (gint) refresh_interval);
+  g_atomic_int_set (&self->snapshot_pending, TRUE);
 
-  g_debug ("Dimensions: width %d, height: %d",
-           self->dimension[DIMENSION_WIDTH], self->dimension[DIMENSION_HEIGHT]);
+  if (refresh_interval > 0)
+    self->refresh_source = g_timeout_add_seconds (refresh_interval,
+                                                  refresh_snapshot,
+                                                  self);
 
-  set_crop (self);
+  update_stream_hold (self);
+}
 
-  return G_SOURCE_CONTINUE;
+guint
+kasasa_screencast_get_refresh_interval (KasasaScreencast *self)
+{
+  g_return_val_if_fail (KASASA_IS_SCREENCAST (self), 0);
+
+  return (guint) g_atomic_int_get (&self->refresh_interval);
 }
 
+// The lowest of the limit set and the one of the low power profile is used
 static void
-compute_first_crop_values (gpointer user_data)
+update_frame_interval (KasasaScreencast *self)
 {
-  compute_crop_values (user_data);
+  guint frame_rate = self->max_frame_rate;
+
+  if (kasasa_settings_get_values (kasasa_settings_get_default ())->pipeline_profile
+      == KASASA_PIPELINE_PROFILE_LOW_POWER
+      && (frame_rate == 0 || frame_rate > LOW_POWER_FRAME_RATE))
+    frame_rate = LOW_POWER_FRAME_RATE;
+
+  g_atomic_int_set (&self->frame_interval_ms,
+                    (frame_rate == 0) ? 0 : (gint) (1000 / frame_rate));
 }
 
+/*
+ * Limit the frames shown by the screencast; a max_frame_rate of 0 removes the
+ * limit. Frames are dropped before being converted or uploaded
+ */
 void
-kasasa_screencast_show (KasasaScreencast *self,
-                        XdpSession       *session,
-                        gint              fd,
-                        guint             node_id)
+kasasa_screencast_set_max_frame_rate (KasasaScreencast *self,
+                                      guint             max_frame_rate)
+{
+  g_return_if_fail (KASASA_IS_SCREENCAST (self));
+
+  self->max_frame_rate = max_frame_rate;
+  update_frame_interval (self);
+}
 
+// The stream's last sample backs the frame copies; it's only released by a
+// complete trim
+static void
+keep_last_sample (KasasaScreencast *self)
 {
-  g_autofree gchar *node_id_str = NULL;
-  GstElement *pipewire_element = NULL;
-  GstElement *filter = NULL, *videocrop = NULL, *gtksink = NULL, *sink = NULL;
-  g_autoptr (GstCaps) caps = NULL;
+  if (!self->trimmed)
+    return;
 
-  GstElement *tee, *queue1, *queue2, *fakesink;
+  kasasa_stream_keep_last_sample (self->stream, TRUE);
+  self->trimmed = FALSE;
+}
 
-  GdkGLContext *gl_context = NULL;
-  GdkPaintable *paintable = NULL;
+// Copy a frame of the stream, cropped to the window as shown
+static GdkTexture *
+sample_to_texture (KasasaScreencast *self,
+                   GstSample        *sample,
+                   graphene_point_t *origin)
+{
+  const GstStructure *structure = NULL;
+  GstCaps *caps = NULL;
+  graphene_rect_t crop;
+  gint width = 0, height = 0;
 
-  GstBus *bus = NULL;
-  GstStateChangeReturn ret;
+  if (sample == NULL || (caps = gst_sample_get_caps (sample)) == NULL)
+    return NULL;
 
-  self->session = session;
-  node_id_str = g_strdup_printf ("%d", node_id);
+  structure = gst_caps_get_structure (caps, 0);
+  gst_structure_get_int (structure, "width", &width);
+  gst_structure_get_int (structure, "height", &height);
 
-  // Create the elements
-  self->pipeline = gst_pipeline_new ("pipeline");
-  pipewire_element = gst_element_factory_make ("pipewiresrc", "pipewire_element");
-  gtksink = gst_element_factory_make ("gtk4paintablesink", "sink");
+  graphene_rect_init (&crop,
+                      self->crop[CROP_LEFT],
+                      self->crop[CROP_TOP],
+                      width - self->crop[CROP_LEFT] - self->crop[CROP_RIGHT],
+                      height - self->crop[CROP_TOP] - self->crop[CROP_BOTTOM]);
 
-  videocrop = gst_element_factory_make ("videocrop", "videocrop");
+  if (origin != NULL)
+    graphene_point_init (origin, crop.origin.x, crop.origin.y);
 
-  caps = gst_caps_from_string ("video/x-raw");
-  filter = gst_element_factory_make ("capsfilter", "filter");
-  g_object_set (filter,
-                "caps", caps,
-                NULL);
+  return kasasa_frame_texture_new (sample, &crop);
+}
 
-  tee = gst_element_factory_make ("tee", "tee");
-  queue1 = gst_element_factory_make ("queue", "queue1");
-  queue2 = gst_element_factory_make ("queue", "queue2");
+/*
+ * Copy the latest frame, cropped to the window as shown; returns NULL if
+ * there's no frame yet, e.g. after a complete trim, in which case the last
+ * sample is kept again for the next call (see kasasa_screencast_get_frame_async ()
+ * to wait for it). The frames are BGRx, as received by the fakesink. If given,
+ * origin is set to the position of the copy in the whole frame
+ */
+GdkTexture *
+kasasa_screencast_get_frame (KasasaScreencast *self,
+                             graphene_point_t *origin)
+{
+  g_autoptr (GstSample) sample = NULL;
 
-  // Create a fakesink to retrieve original frames
-  fakesink = gst_element_factory_make ("fakesink", "fakesink");
+  g_return_val_if_fail (KASASA_IS_SCREENCAST (self), NULL);
 
-  if (!self->pipeline || !pipewire_element || !tee
-      || !queue1 || !filter || !videocrop || !gtksink
-      || !queue2 || !fakesink)
-    {
-      g_warning ("Not all elements could be created.");
-      return;
-    }
+  if (!is_running (self))
+    return NULL;
 
-  // Set the fd and node ID
-  g_object_set (pipewire_element,
-                "fd",  fd,
-                "path", node_id_str,
-                NULL);
+  keep_last_sample (self);
 
-  g_debug ("fd: %d; node_id: %s", fd, node_id_str);
+  sample = kasasa_stream_get_last_sample (self->stream);
 
-  // Get the GLContex and GdkPaintable
-  g_object_get (gtksink,
-                "paintable", &paintable,
-                NULL);
+  return sample_to_texture (self, sample, origin);
+}
 
-  g_object_get (paintable,
-                "gl-context", &gl_context,
-                NULL);
+static void
+kasasa_screencast_suspend (KasasaContent *content)
+{
+  KasasaScreencast *self = NULL;
 
-  // Check for GLContext
-  if (gl_context)
-    {
-      g_info ("Using GL");
-      sink = gst_element_factory_make ("glsinkbin", "glsinkbin");
-      g_object_set (sink,
-                    "sink", gtksink,
-                    NULL);
-    }
-  else
-    {
-      GstElement *convert = NULL;
+  g_return_if_fail (KASASA_IS_SCREENCAST (content));
 
-      g_info ("Not using GL");
-      convert = gst_element_factory_make ("videoconvert", "convert");
-      sink = gst_bin_new ("gst_bin");
-      gst_bin_add_many (GST_BIN (sink), convert, gtksink, NULL);
-      gst_element_link (convert, gtksink);
-    }
+  self = KASASA_SCREENCAST (content);
 
-  // Build the pipeline
-  gst_bin_add_many (GST_BIN (self->pipeline),
-                    pipewire_element, tee, queue1, filter, videocrop, sink,
-                    queue2, fakesink, NULL);
-  if (!gst_element_link_many (pipewire_element,
-                              tee, queue1, filter, videocrop, sink, NULL)
-       || !gst_element_link_many (tee, queue2, fakesink, NULL)
-      )
-    {
-      g_warning ("Elements could not be linked.");
-      return;
-    }
+  // Stays suspended when the thumbnail is stopped
+  self->thumbnail_suspended = FALSE;
 
-  // Set the paintable
-  gtk_picture_set_paintable (self->picture, paintable);
+  if (self->suspended || !is_running (self))
+    return;
 
-  // Configure the bus
-  bus = gst_element_get_bus (self->pipeline);
-  gst_bus_add_signal_watch (bus);
-  g_signal_connect (G_OBJECT (bus), "message::error", (GCallback) error_cb, self);
-  g_signal_connect (G_OBJECT (bus), "message::eos", (GCallback) eos_cb, self);
-  gst_object_unref (bus);
+  g_debug ("Suspending screencast");
 
-  // Start playing
-  ret = gst_element_set_state (self->pipeline, GST_STATE_PLAYING);
-  if (ret == GST_STATE_CHANGE_FAILURE)
-    {
-      g_warning ("Unable to set the pipeline to the playing state.");
+  g_atomic_int_set (&self->suspended, TRUE);
+  update_stream_hold (self);
+}
+
+static void
+kasasa_screencast_resume (KasasaContent *content)
+{
+  KasasaScreencast *self = NULL;
+
+  g_return_if_fail (KASASA_IS_SCREENCAST (content));
+
+  self = KASASA_SCREENCAST (content);
+
+  if (!is_running (self))
+    return;
+
+  keep_last_sample (self);
+
+  if (self->suspended)
+    {
+      g_debug ("Resuming screencast");
+
+      g_atomic_int_set (&self->suspended, FALSE);
+      // Frames were dropped while suspended, so the next one is let through
+      g_atomic_int_set (&self->reset_checksum, TRUE);
+      // Show a fresh snapshot right away
+      g_atomic_int_set (&self->snapshot_pending, TRUE);
+      update_stream_hold (self);
+    }
+}
+
+static void
+kasasa_screencast_trim_memory (KasasaContent    *content,
+                               ContentTrimLevel  level)
+{
+  KasasaScreencast *self = NULL;
+
+  g_return_if_fail (KASASA_IS_SCREENCAST (content));
+
+  self = KASASA_SCREENCAST (content);
+
+  // The last sample backs copies, freeze frames and the crop, so it's only
+  // released along with the frames of the branch
+  if (!is_running (self) || level != CONTENT_TRIM_LEVEL_COMPLETE)
+    return;
+
+  if (!self->trimmed)
+    {
+      kasasa_stream_keep_last_sample (self->stream, FALSE);
+      self->trimmed = TRUE;
+    }
+
+  // Suspended, the branch lets no frame through, so its queue drains and only
+  // the frame shown by the sink is kept
+  kasasa_screencast_suspend (content);
+}
+
+static gsize
+kasasa_screencast_get_memory_usage (KasasaContent *content)
+{
+  KasasaScreencast *self = NULL;
+  gsize frame_size;
+  guint n_frames = 0;
+  guint max_queued = 0;
+
+  g_return_val_if_fail (KASASA_IS_SCREENCAST (content), 0);
+
+  self = KASASA_SCREENCAST (content);
+
+  if (!is_running (self))
+    return 0;
+
+  // Estimate from the uncropped frame, with 4 bytes per pixel
+  frame_size =
+    (gsize) (self->dimension[DIMENSION_WIDTH] + self->crop[CROP_LEFT] + self->crop[CROP_RIGHT])
+    * (self->dimension[DIMENSION_HEIGHT] + self->crop[CROP_TOP] + self->crop[CROP_BOTTOM])
+    * 4;
+
+  // Frames queued in the branch (set by the pipeline profile); none are let
+  // through while suspended
+  if (self->queue != NULL && !g_atomic_int_get (&self->suspended))
+    {
+      g_object_get (self->queue, "max-size-buffers", &max_queued, NULL);
+      n_frames += max_queued;
+    }
+
+  // The frame shown by the sink
+  if (self->sink != NULL)
+    n_frames++;
+
+  // The last sample of the stream's fakesink, kept until trimmed
+  if (!self->trimmed)
+    n_frames++;
+
+  return frame_size * n_frames;
+}
+
+static void
+on_stream_eos (KasasaStream *stream,
+               gpointer      user_data)
+{
+  KasasaScreencast *self = KASASA_SCREENCAST (user_data);
+
+  if (!kasasa_stream_can_reconnect (stream))
+    {
+      g_signal_emit (self,
+                     obj_signals[SIGNAL_EOS],
+                     0);
+      return;
+    }
+
+  // The branch is kept with the stream, and the dimension with the page
+  adw_status_page_set_title (self->no_screencast_page, _("Screencast ended"));
+  gtk_widget_set_visible (self->reconnect_button, TRUE);
+  gtk_stack_set_visible_child (self->stack, GTK_WIDGET (self->no_screencast_page));
+}
+
+static void
+on_stream_reconnected (KasasaStream *stream,
+                       gpointer      user_data)
+{
+  KasasaScreencast *self = KASASA_SCREENCAST (user_data);
+
+  g_atomic_int_set (&self->reset_checksum, TRUE);
+  gtk_widget_set_visible (self->reconnect_button, FALSE);
+  gtk_stack_set_visible_child (self->stack, self->offload);
+}
+
+static void
+on_reconnect_button_clicked (GtkButton *button,
+                             gpointer   user_data)
+{
+  g_signal_emit (user_data,
+                 obj_signals[SIGNAL_RECONNECT],
+                 0);
+}
+
+static void
+on_stream_error (KasasaStream *stream,
+                 const gchar  *message,
+                 gpointer      user_data)
+{
+  KasasaScreencast *self = KASASA_SCREENCAST (user_data);
+
+  adw_status_page_set_title (self->no_screencast_page,
+                             _("Screencast ended with error"));
+  set_no_screencast (self);
+  detach_stream (self);
+}
+
+// The smaller side of the displayed area is scaled to the thumbnail size; the
+// other one follows the aspect ratio
+static void
+update_thumbnail (KasasaScreencast *self)
+{
+  g_autoptr (GstCaps) caps = NULL;
+  gboolean landscape;
+
+  if (self->thumbnail_branch == NULL)
+    return;
+
+  g_object_set (self->thumbnail_videocrop,
+                "top", self->crop[CROP_TOP],
+                "right", self->crop[CROP_RIGHT],
+                "bottom", self->crop[CROP_BOTTOM],
+                "left", self->crop[CROP_LEFT],
+                NULL);
+
+  landscape = self->dimension[DIMENSION_WIDTH] >= self->dimension[DIMENSION_HEIGHT];
+  caps = gst_caps_new_simple ("video/x-raw",
+                              landscape ? "height" : "width", G_TYPE_INT, self->thumbnail_size,
+                              "pixel-aspect-ratio", GST_TYPE_FRACTION, 1, 1,
+                              NULL);
+  g_object_set (self->thumbnail_filter,
+                "caps", caps,
+                NULL);
+}
+
+// The crop is changed while playing: the stream may be shared
+static void
+set_crop (KasasaScreencast *self)
+{
+  if (!self->videocrop && !self->crop_meta)
+    {
+      g_warning ("Failed to set video crop");
+      return;
+    }
+
+  // The displayed area changed, so must the frame
+  g_atomic_int_set (&self->reset_checksum, TRUE);
+
+  // The crop meta is set from the crop values on each frame
+  if (self->crop_meta)
+    {
+      update_thumbnail (self);
+      return;
+    }
+
+  g_object_set (self->videocrop,
+                "top", self->crop[CROP_TOP],
+                "right", self->crop[CROP_RIGHT],
+                "bottom", self->crop[CROP_BOTTOM],
+                "left", self->crop[CROP_LEFT],
+                NULL);
+
+  update_thumbnail (self);
+}
+
+static void
+new_dimension (KasasaScreencast *self,
+               gint              new_width,
+               gint              new_height)
+{
+  if (self->dimension[DIMENSION_WIDTH] != new_width
+      || self->dimension[DIMENSION_HEIGHT] != new_height)
+    {
+      g_signal_emit (self,
+                     obj_signals[SIGNAL_NEW_DIMENSION],
+                     0,
+                     new_width,
+                     new_height);
+    }
+
+  // We expect a window following the GTK/ADW minimal dimensions
+  self->dimension[DIMENSION_WIDTH] = MAX (new_width, DEFAULT_WIDTH);
+  self->dimension[DIMENSION_HEIGHT] = MAX (new_height, DEFAULT_HEIGHT);
+}
+
+static gboolean
+compute_crop_values (gpointer user_data)
+{
+  KasasaScreencast *self = NULL;
+  g_autoptr (GstSample) sample = NULL;
+  GstBuffer *buffer = NULL;
+  const GstCaps *caps = NULL;
+  GstMapInfo map;
+
+  gint width = 0;
+  gint height = 0;
+
+  self = KASASA_SCREENCAST (user_data);
+
+  // The frames don't change while suspended, and a fixed region is kept
+  if (self->suspended || self->fixed_region)
+    return G_SOURCE_CONTINUE;
+
+  if (self->stream == NULL)
+    {
+      g_warning ("Got stream == NULL while processing crop dimensions. "\
+                 "Unable to crop to window size.");
+      return G_SOURCE_REMOVE;
+    }
+
+  // Get sample
+  sample = kasasa_stream_get_last_sample (self->stream);
+  if (sample == NULL)
+    {
+      g_debug ("sample == NULL while processing crop dimensions");
+      return G_SOURCE_CONTINUE;
+    }
+
+  // Get sample info
+  caps = gst_sample_get_caps (sample);
+  if (caps)
+    {
+      const GstStructure *structure;
+      const gchar *format;
+
+      structure = gst_caps_get_structure (caps, 0);
+      format = gst_structure_get_string (structure, "format");
+
+      // Check if the format is BGRx
+      if (g_strcmp0 (format, "BGRx") == 0)
+        {
+          gst_structure_get_int (structure, "width", &width);
+          gst_structure_get_int (structure, "height", &height);
+        }
+      else
+        {
+          g_warning ("Expected format BGRx, but received: %s. "\
+                     "Unable to crop to window size.", format);
+          gst_buffer_unmap (buffer, &map);
+          return G_SOURCE_REMOVE;
+        }
+    }
+
+  // Ensure the width and height of the sample is ok
+  if (width < 100 || height < 100)
+    {
+      g_warning ("Sample is too small, crop skipped");
+      return G_SOURCE_REMOVE;
+    }
+
+  // Get crop dimensions
+  buffer = gst_sample_get_buffer (sample);
+  if (gst_buffer_map (buffer, &map, GST_MAP_READ))
+    {
+      gint top = height, bottom = 0, left = width, right = 0;
+
+      // Analyze the pixel data
+      // (I) Columns
+      for (gint y = 0; y < height; y++)
+        {
+          for (gint x = 0; x < width; x = (x+1)*4)
+            {
+              // 4 bytes per pixel (B, G, R, X)
+              gint index = (y * width + x) * 4;
+
+              guchar b = map.data[index];
+              guchar g = map.data[index + 1];
+              guchar r = map.data[index + 2];
+
+              // Check if the pixel is not black (ignoring the alpha channel)
+              if (b != 0 || g != 0 || r != 0)
+                {
+                  if (y < top) top = y;
+                  if (y > bottom) bottom = y;
+                }
+            }
+        }
+
+      for (gint y = 0; y < height; y = (y+1)*4)
+        {
+          for (gint x = 0; x < width; x++)
+            {
+              gint index = (y * width + x) * 4;
+
+              guchar b = map.data[index];
+              guchar g = map.data[index + 1];
+              guchar r = map.data[index + 2];
+
+              if (b != 0 || g != 0 || r != 0)
+                {
+                  if (x < left) left = x;
+                  if (x > right) right = x;
+                }
+            }
+        }
+
+      // Crop values
+      self->crop[CROP_TOP] = top;
+      self->crop[CROP_RIGHT] = width - right;
+      self->crop[CROP_BOTTOM] = height - bottom;
+      self->crop[CROP_LEFT] = left;
+
+      new_dimension (self,
+                     (right - left),          // width
+                     (bottom - top));         // height
+
+      gst_buffer_unmap (buffer, &map);
+    }
+
+  g_debug ("Crop values: top: %d, bottom: %d, left: %d, right: %d",
+           self->crop[CROP_TOP], self->crop[CROP_BOTTOM],
+           self->crop[CROP_LEFT], self->crop[CROP_RIGHT]);
+
+  g_debug ("Dimensions: width %d, height: %d",
+           self->dimension[DIMENSION_WIDTH], self->dimension[DIMENSION_HEIGHT]);
+
+  set_crop (self);
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+compute_first_crop_values (gpointer user_data)
+{
+  compute_crop_values (user_data);
+}
+
+static gpointer
+gst_init_thread_func (gpointer user_data)
+{
+  gst_init (NULL, NULL);
+  g_debug ("GStreamer initialized in background");
+
+  return NULL;
+}
+
+/*
+ * Start loading GStreamer (and its plugin registry) on a background thread;
+ * it's safe to call this function multiple times
+ */
+void
+kasasa_screencast_preload (void)
+{
+  g_mutex_lock (&gst_init_mutex);
+
+  if (!gst_initialized && gst_init_thread == NULL)
+    gst_init_thread = g_thread_new ("kasasa-gst-init", gst_init_thread_func, NULL);
+
+  g_mutex_unlock (&gst_init_mutex);
+}
+
+// Block until GStreamer is initialized; if preloading wasn't requested,
+// initialize it right now
+void
+kasasa_screencast_ensure_gstreamer (void)
+{
+  GThread *thread = NULL;
+  gboolean initialized;
+
+  g_mutex_lock (&gst_init_mutex);
+  thread = g_steal_pointer (&gst_init_thread);
+  initialized = gst_initialized;
+  g_mutex_unlock (&gst_init_mutex);
+
+  if (thread != NULL)
+    g_thread_join (thread);
+  else if (!initialized)
+    gst_init (NULL, NULL);
+
+  g_mutex_lock (&gst_init_mutex);
+  gst_initialized = TRUE;
+  g_mutex_unlock (&gst_init_mutex);
+}
+
+// Latency and work trade-off of the branch; the queue only ever keeps the
+// newest frames, so a slow sink never shows a backlog. Low power also limits
+// the frame rate, so fewer frames are converted and uploaded
+static void
+apply_pipeline_profile (KasasaScreencast *self)
+{
+  KasasaPipelineProfile profile =
+    kasasa_settings_get_values (kasasa_settings_get_default ())->pipeline_profile;
+  guint max_buffers = 1;
+  gboolean sync = TRUE;
+  gint64 max_lateness = 20 * GST_MSECOND;
+
+  update_frame_interval (self);
+
+  if (self->queue == NULL || self->sink == NULL)
+    return;
+
+  if (profile == KASASA_PIPELINE_PROFILE_LOW_LATENCY)
+    {
+      // Render each frame as soon as it arrives, ignoring its timestamp
+      sync = FALSE;
+      max_lateness = -1;
+    }
+  else if (profile == KASASA_PIPELINE_PROFILE_LOW_POWER)
+    {
+      // Late frames are dropped, and QoS makes upstream skip their work too
+      max_lateness = 5 * GST_MSECOND;
+    }
+  else
+    {
+      max_buffers = 2;
+    }
+
+  g_object_set (self->queue,
+                "max-size-buffers", max_buffers,
+                "max-size-bytes", 0,
+                "max-size-time", (guint64) 0,
+                "leaky", 2,               // downstream: drop the oldest frame
+                NULL);
+
+  g_object_set (self->sink,
+                "sync", sync,
+                "qos", sync,
+                "max-lateness", max_lateness,
+                NULL);
+}
+
+static void
+on_pipeline_profile_changed (KasasaSettings *settings,
+                             const gchar    *key,
+                             gpointer        user_data)
+{
+  apply_pipeline_profile (KASASA_SCREENCAST (user_data));
+}
+
+// Whether gtk4paintablesink can import dmabufs, which it shows as dmabuf
+// textures
+static gboolean
+sink_accepts_dmabuf (GstElement *sink)
+{
+  g_autoptr (GstPad) pad = gst_element_get_static_pad (sink, "sink");
+  g_autoptr (GstCaps) caps = gst_pad_get_pad_template_caps (pad);
+
+  for (guint i = 0; i < gst_caps_get_size (caps); i++)
+    {
+      if (gst_caps_features_contains (gst_caps_get_features (caps, i), "memory:DMABuf"))
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+// Crop the frame with a meta, as videocrop would copy a dmabuf into memory
+static GstPadProbeReturn
+crop_meta_probe_cb (GstPad          *pad,
+                    GstPadProbeInfo *info,
+                    gpointer         user_data)
+{
+  KasasaScreencast *self = KASASA_SCREENCAST (user_data);
+  GstBuffer *buffer = NULL;
+  GstVideoCropMeta *meta = NULL;
+  gint left = g_atomic_int_get (&self->crop[CROP_LEFT]);
+  gint top = g_atomic_int_get (&self->crop[CROP_TOP]);
+  gint width = GST_VIDEO_INFO_WIDTH (&self->frame_info) - left - g_atomic_int_get (&self->crop[CROP_RIGHT]);
+  gint height = GST_VIDEO_INFO_HEIGHT (&self->frame_info) - top - g_atomic_int_get (&self->crop[CROP_BOTTOM]);
+
+  // The frame info is set by the throttle probe, upstream of this one
+  if (!self->has_frame_info || left < 0 || top < 0 || width <= 0 || height <= 0)
+    return GST_PAD_PROBE_OK;
+
+  // Only the buffer is copied; the dmabuf itself is shared
+  buffer = gst_buffer_make_writable (GST_PAD_PROBE_INFO_BUFFER (info));
+  GST_PAD_PROBE_INFO_DATA (info) = buffer;
+
+  meta = gst_buffer_get_video_crop_meta (buffer);
+  if (meta == NULL)
+    meta = gst_buffer_add_video_crop_meta (buffer);
+
+  meta->x = left;
+  meta->y = top;
+  meta->width = width;
+  meta->height = height;
+
+  return GST_PAD_PROBE_OK;
+}
+
+/*
+ * Build this screencast's branch: queue ! capsfilter ! videocrop ! sink.
+ * When the sink can import dmabufs, they are preferred and cropped with a
+ * crop meta instead, so that they reach GTK as dmabuf textures and can be
+ * offloaded; the stream still negotiates raw frames if another branch needs
+ * them
+ */
+static GstElement *
+create_branch (KasasaScreencast *self)
+{
+  GstElement *branch = NULL, *queue = NULL;
+  GstElement *filter = NULL, *gtksink = NULL, *sink = NULL;
+  g_autoptr (GstCaps) caps = NULL;
+  GstPad *pad = NULL;
+
+  GdkGLContext *gl_context = NULL;
+  GdkPaintable *paintable = NULL;
+
+  branch = gst_bin_new (NULL);
+  queue = gst_element_factory_make ("queue", NULL);
+  gtksink = gst_element_factory_make ("gtk4paintablesink", NULL);
+  filter = gst_element_factory_make ("capsfilter", NULL);
+
+  if (!branch || !queue || !filter || !gtksink)
+    {
+      g_warning ("Not all elements could be created.");
+      return NULL;
+    }
+
+  // Get the GLContex and GdkPaintable
+  g_object_get (gtksink,
+                "paintable", &paintable,
+                NULL);
+
+  g_object_get (paintable,
+                "gl-context", &gl_context,
+                NULL);
+
+  // Check for GLContext
+  if (gl_context && sink_accepts_dmabuf (gtksink))
+    {
+      g_info ("Using dmabufs");
+      caps = gst_caps_from_string (DMABUF_CAPS "; video/x-raw");
+      self->crop_meta = TRUE;
+      sink = gtksink;
+    }
+  else if (gl_context)
+    {
+      g_info ("Using GL");
+      caps = gst_caps_from_string ("video/x-raw");
+      sink = gst_element_factory_make ("glsinkbin", NULL);
+      g_object_set (sink,
+                    "sink", gtksink,
+                    NULL);
+    }
+  else
+    {
+      GstElement *convert = NULL, *texture_filter = NULL;
+      g_autoptr (GstCaps) texture_caps = NULL;
+
+      g_info ("Not using GL");
+      caps = gst_caps_from_string ("video/x-raw");
+      // Placed after videocrop, so only the displayed area is converted, when
+      // the stream isn't already in a memory texture format
+      convert = gst_element_factory_make ("videoconvert", NULL);
+      g_object_set (convert,
+                    "n-threads", g_get_num_processors (),
+                    NULL);
+
+      texture_caps = gst_caps_from_string (MEMORY_TEXTURE_CAPS);
+      texture_filter = gst_element_factory_make ("capsfilter", NULL);
+      g_object_set (texture_filter,
+                    "caps", texture_caps,
+                    NULL);
+
+      sink = gst_bin_new (NULL);
+      gst_bin_add_many (GST_BIN (sink), convert, texture_filter, gtksink, NULL);
+      gst_element_link_many (convert, texture_filter, gtksink, NULL);
+
+      pad = gst_element_get_static_pad (convert, "sink");
+      gst_element_add_pad (sink, gst_ghost_pad_new ("sink", pad));
+      gst_object_unref (pad);
+    }
+
+  g_object_set (filter,
+                "caps", caps,
+                NULL);
+
+  if (!self->crop_meta)
+    self->videocrop = gst_element_factory_make ("videocrop", NULL);
+
+  if (!self->crop_meta && !self->videocrop)
+    {
+      g_warning ("Not all elements could be created.");
+      gst_object_unref (branch);
+      g_object_unref (paintable);
+      g_clear_object (&gl_context);
+      return NULL;
+    }
+
+  if (self->crop_meta)
+    {
+      gst_bin_add_many (GST_BIN (branch), queue, filter, sink, NULL);
+      if (!gst_element_link_many (queue, filter, sink, NULL))
+        {
+          g_warning ("Elements could not be linked.");
+          gst_object_unref (branch);
+          self->crop_meta = FALSE;
+          g_object_unref (paintable);
+          g_clear_object (&gl_context);
+          return NULL;
+        }
+
+      pad = gst_element_get_static_pad (gtksink, "sink");
+      gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER,
+                         crop_meta_probe_cb, self, NULL);
+      gst_object_unref (pad);
+    }
+  else
+    {
+      gst_bin_add_many (GST_BIN (branch), queue, filter, self->videocrop, sink, NULL);
+      if (!gst_element_link_many (queue, filter, self->videocrop, sink, NULL))
+        {
+          g_warning ("Elements could not be linked.");
+          gst_object_unref (branch);
+          self->videocrop = NULL;
+          g_object_unref (paintable);
+          g_clear_object (&gl_context);
+          return NULL;
+        }
+    }
+
+  self->queue = queue;
+  self->sink = gtksink;
+  apply_pipeline_profile (self);
+
+  pad = gst_element_get_static_pad (queue, "sink");
+  gst_element_add_pad (branch, gst_ghost_pad_new ("sink", pad));
+
+  // Throttle the displayed frames when requested
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+                     throttle_probe_cb, self, NULL);
+  gst_object_unref (pad);
+
+  // Set the paintable
+  gtk_picture_set_paintable (self->picture, paintable);
+  g_object_unref (paintable);
+  g_clear_object (&gl_context);
+
+  return branch;
+}
+
+typedef struct
+{
+  GstSample               *sample;
+  graphene_rect_t          crop;
+} WatchData;
+
+typedef struct
+{
+  KasasaScreencast        *screencast;
+  GstSample               *sample;
+} ProbedFrame;
+
+static void
+watch_data_free (gpointer user_data)
+{
+  WatchData *data = user_data;
+
+  gst_sample_unref (data->sample);
+  g_free (data);
+}
+
+static void
+probed_frame_free (gpointer user_data)
+{
+  ProbedFrame *frame = user_data;
+
+  g_object_unref (frame->screencast);
+  gst_sample_unref (frame->sample);
+  g_free (frame);
+}
+
+static void
+compute_signature_thread (GTask        *task,
+                          gpointer      source_object,
+                          gpointer      task_data,
+                          GCancellable *cancellable)
+{
+  WatchData *data = task_data;
+  guint8 *signature = NULL;
+
+  signature = kasasa_frame_get_signature (data->sample, &data->crop, WATCH_GRID_SIZE);
+  if (signature == NULL)
+    g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_FAILED,
+                             "Couldn't compute the frame signature");
+  else
+    g_task_return_pointer (task, signature, g_free);
+}
+
+static void
+on_signature_computed (GObject      *source_object,
+                       GAsyncResult *res,
+                       gpointer      user_data)
+{
+  KasasaScreencast *self = KASASA_SCREENCAST (source_object);
+  g_autoptr (GError) error = NULL;
+  g_autofree guint8 *signature = NULL;
+  guint n_changed_blocks = 0;
+
+  signature = g_task_propagate_pointer (G_TASK (res), &error);
+
+  // Watching was stopped
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    return;
+
+  g_clear_object (&self->watch_cancellable);
+
+  if (error != NULL)
+    {
+      g_debug ("%s", error->message);
+      return;
+    }
+
+  // The first frame is the reference
+  if (self->watch_signature == NULL)
+    {
+      self->watch_signature = g_steal_pointer (&signature);
+      return;
+    }
+
+  // Compared with the reference, so that slow changes add up
+  for (guint i = 0; i < WATCH_GRID_SIZE * WATCH_GRID_SIZE; i++)
+    if (ABS ((gint) signature[i] - (gint) self->watch_signature[i]) > WATCH_BLOCK_THRESHOLD)
+      n_changed_blocks++;
+
+  if (n_changed_blocks >= WATCH_N_CHANGED_BLOCKS)
+    {
+      g_debug ("Watched screencast changed (%u blocks)", n_changed_blocks);
+
+      g_free (self->watch_signature);
+      self->watch_signature = g_steal_pointer (&signature);
+
+      g_signal_emit (self,
+                     obj_signals[SIGNAL_CHANGED],
+                     0);
+    }
+}
+
+// The stream is only played for the watch until a frame is taken
+static void
+release_watch_hold (KasasaScreencast *self)
+{
+  g_clear_handle_id (&self->watch_frame_timeout_source, g_source_remove);
+
+  if (!self->watch_holding_stream)
+    return;
+
+  self->watch_holding_stream = FALSE;
+  kasasa_stream_pause (self->stream);
+}
+
+// Compute the signature of the frame taken, on a worker thread
+static gboolean
+on_watch_frame (gpointer user_data)
+{
+  ProbedFrame *frame = user_data;
+  KasasaScreencast *self = frame->screencast;
+  g_autoptr (GTask) task = NULL;
+  const GstStructure *structure = NULL;
+  GstCaps *caps = NULL;
+  WatchData *data = NULL;
+  gint width = 0, height = 0;
+
+  // Watching was stopped
+  if (self->watch_source == 0)
+    return G_SOURCE_REMOVE;
+
+  release_watch_hold (self);
+
+  caps = gst_sample_get_caps (frame->sample);
+  if (caps == NULL)
+    return G_SOURCE_REMOVE;
+
+  structure = gst_caps_get_structure (caps, 0);
+  gst_structure_get_int (structure, "width", &width);
+  gst_structure_get_int (structure, "height", &height);
+
+  // Only the pixels shown are compared
+  data = g_new0 (WatchData, 1);
+  data->sample = gst_sample_ref (frame->sample);
+  graphene_rect_init (&data->crop,
+                      self->crop[CROP_LEFT],
+                      self->crop[CROP_TOP],
+                      width - self->crop[CROP_LEFT] - self->crop[CROP_RIGHT],
+                      height - self->crop[CROP_TOP] - self->crop[CROP_BOTTOM]);
+
+  self->watch_cancellable = g_cancellable_new ();
+  task = g_task_new (self, self->watch_cancellable, on_signature_computed, NULL);
+  g_task_set_source_tag (task, on_watch_frame);
+  g_task_set_task_data (task, data, watch_data_free);
+  g_task_run_in_thread (task, compute_signature_thread);
+
+  return G_SOURCE_REMOVE;
+}
+
+// Take a requested frame before the branch drops it (e.g. while suspended)
+static GstPadProbeReturn
+watch_probe_cb (GstPad          *pad,
+                GstPadProbeInfo *info,
+                gpointer         user_data)
+{
+  KasasaScreencast *self = KASASA_SCREENCAST (user_data);
+  g_autoptr (GstCaps) caps = NULL;
+  ProbedFrame *frame = NULL;
+
+  if (!g_atomic_int_compare_and_exchange (&self->watch_frame_pending, TRUE, FALSE))
+    return GST_PAD_PROBE_OK;
+
+  caps = gst_pad_get_current_caps (pad);
+  if (caps == NULL)
+    {
+      g_atomic_int_set (&self->watch_frame_pending, TRUE);
+      return GST_PAD_PROBE_OK;
+    }
+
+  frame = g_new0 (ProbedFrame, 1);
+  frame->screencast = g_object_ref (self);
+  frame->sample = gst_sample_new (GST_PAD_PROBE_INFO_BUFFER (info), caps, NULL, NULL);
+  g_main_context_invoke_full (NULL, G_PRIORITY_DEFAULT,
+                              on_watch_frame,
+                              frame, probed_frame_free);
+
+  return GST_PAD_PROBE_OK;
+}
+
+// No new frame: the window didn't change
+static gboolean
+on_watch_frame_timeout (gpointer user_data)
+{
+  KasasaScreencast *self = KASASA_SCREENCAST (user_data);
+
+  self->watch_frame_timeout_source = 0;
+
+  if (g_atomic_int_compare_and_exchange (&self->watch_frame_pending, TRUE, FALSE))
+    release_watch_hold (self);
+
+  return G_SOURCE_REMOVE;
+}
+
+// Play the stream until a single frame is taken
+static gboolean
+check_watched_frame (gpointer user_data)
+{
+  KasasaScreencast *self = KASASA_SCREENCAST (user_data);
+
+  // The previous check is still running
+  if (self->watch_holding_stream || self->watch_cancellable != NULL)
+    return G_SOURCE_CONTINUE;
+
+  g_atomic_int_set (&self->watch_frame_pending, TRUE);
+  self->watch_holding_stream = TRUE;
+  kasasa_stream_play (self->stream);
+
+  self->watch_frame_timeout_source = g_timeout_add (WATCH_FRAME_TIMEOUT,
+                                                    on_watch_frame_timeout,
+                                                    self);
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+stop_watching (KasasaScreencast *self)
+{
+  g_autoptr (GstPad) pad = NULL;
+
+  if (self->watch_source == 0)
+    return;
+
+  g_clear_handle_id (&self->watch_source, g_source_remove);
+  g_atomic_int_set (&self->watch_frame_pending, FALSE);
+  release_watch_hold (self);
+  g_cancellable_cancel (self->watch_cancellable);
+  g_clear_object (&self->watch_cancellable);
+  g_clear_pointer (&self->watch_signature, g_free);
+
+  pad = gst_element_get_static_pad (self->branch, "sink");
+  gst_pad_remove_probe (pad, self->watch_probe_id);
+  self->watch_probe_id = 0;
+}
+
+static void
+start_watching (KasasaScreencast *self)
+{
+  g_autoptr (GstPad) pad = NULL;
+
+  if (self->watch_source != 0 || self->stream == NULL)
+    return;
+
+  // The branch's own pad comes before the throttle probe, which drops frames
+  pad = gst_element_get_static_pad (self->branch, "sink");
+  self->watch_probe_id = gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER,
+                                            watch_probe_cb, self, NULL);
+
+  self->watch_source = g_timeout_add_seconds (WATCH_INTERVAL,
+                                              check_watched_frame,
+                                              self);
+
+  // Take the reference frame right away
+  check_watched_frame (self);
+}
+
+/*
+ * In watch mode, the "changed" signal is emitted when the frame shown changes
+ * noticeably; a single frame is taken at a low rate and compared on a worker
+ * thread, while the screencast is suspended or trimmed too
+ */
+void
+kasasa_screencast_set_watching (KasasaScreencast *self,
+                                gboolean          watching)
+{
+  g_return_if_fail (KASASA_IS_SCREENCAST (self));
+
+  self->watching = watching;
+
+  if (watching && is_running (self))
+    start_watching (self);
+  else
+    stop_watching (self);
+}
+
+gboolean
+kasasa_screencast_get_watching (KasasaScreencast *self)
+{
+  g_return_val_if_fail (KASASA_IS_SCREENCAST (self), FALSE);
+
+  return self->watching;
+}
+
+typedef struct
+{
+  GdkTexture              *texture;
+  graphene_point_t         origin;
+} FrameResult;
+
+static void
+frame_result_free (gpointer user_data)
+{
+  FrameResult *result = user_data;
+
+  g_clear_object (&result->texture);
+  g_free (result);
+}
+
+// The stream is only played for the requests until a frame is taken
+static void
+release_frame_hold (KasasaScreencast *self)
+{
+  g_autoptr (GstPad) pad = NULL;
+
+  g_clear_handle_id (&self->frame_timeout_source, g_source_remove);
+  g_atomic_int_set (&self->frame_request_pending, FALSE);
+
+  if (self->frame_probe_id > 0)
+    {
+      pad = gst_element_get_static_pad (self->branch, "sink");
+      gst_pad_remove_probe (pad, self->frame_probe_id);
+      self->frame_probe_id = 0;
+    }
+
+  if (!self->frame_holding_stream)
+    return;
+
+  self->frame_holding_stream = FALSE;
+  kasasa_stream_pause (self->stream);
+}
+
+// Serve the waiting requests with the frame, or fail them if there's none
+static void
+complete_frame_requests (KasasaScreencast *self,
+                         GstSample        *sample)
+{
+  g_autoptr (GPtrArray) tasks = g_steal_pointer (&self->frame_tasks);
+
+  release_frame_hold (self);
+
+  if (tasks == NULL)
+    return;
+
+  for (guint i = 0; i < tasks->len; i++)
+    {
+      GTask *task = g_ptr_array_index (tasks, i);
+      FrameResult *result = g_new0 (FrameResult, 1);
+
+      result->texture = sample_to_texture (self, sample, &result->origin);
+      if (result->texture == NULL)
+        {
+          frame_result_free (result);
+          g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_FAILED,
+                                   "No frame received");
+          continue;
+        }
+
+      g_task_return_pointer (task, result, frame_result_free);
+    }
+}
+
+static gboolean
+on_requested_frame (gpointer user_data)
+{
+  ProbedFrame *frame = user_data;
+
+  complete_frame_requests (frame->screencast, frame->sample);
+
+  return G_SOURCE_REMOVE;
+}
+
+// Take the requested frame before the branch drops it (e.g. while suspended)
+static GstPadProbeReturn
+frame_request_probe_cb (GstPad          *pad,
+                        GstPadProbeInfo *info,
+                        gpointer         user_data)
+{
+  KasasaScreencast *self = KASASA_SCREENCAST (user_data);
+  g_autoptr (GstCaps) caps = NULL;
+  ProbedFrame *frame = NULL;
+
+  if (!g_atomic_int_compare_and_exchange (&self->frame_request_pending, TRUE, FALSE))
+    return GST_PAD_PROBE_OK;
+
+  caps = gst_pad_get_current_caps (pad);
+  if (caps == NULL)
+    {
+      g_atomic_int_set (&self->frame_request_pending, TRUE);
+      return GST_PAD_PROBE_OK;
+    }
+
+  frame = g_new0 (ProbedFrame, 1);
+  frame->screencast = g_object_ref (self);
+  frame->sample = gst_sample_new (GST_PAD_PROBE_INFO_BUFFER (info), caps, NULL, NULL);
+  g_main_context_invoke_full (NULL, G_PRIORITY_DEFAULT,
+                              on_requested_frame,
+                              frame, probed_frame_free);
+
+  return GST_PAD_PROBE_OK;
+}
+
+// No new frame: the last sample may have been received meanwhile
+static gboolean
+on_frame_request_timeout (gpointer user_data)
+{
+  KasasaScreencast *self = KASASA_SCREENCAST (user_data);
+  g_autoptr (GstSample) sample = NULL;
+
+  self->frame_timeout_source = 0;
+
+  if (g_atomic_int_compare_and_exchange (&self->frame_request_pending, TRUE, FALSE))
+    {
+      sample = kasasa_stream_get_last_sample (self->stream);
+      complete_frame_requests (self, sample);
+    }
+
+  return G_SOURCE_REMOVE;
+}
+
+/*
+ * Like kasasa_screencast_get_frame (), but if there's no frame yet, the stream
+ * is played until a new one is received, for up to FRAME_REQUEST_TIMEOUT
+ */
+void
+kasasa_screencast_get_frame_async (KasasaScreencast    *self,
+                                   GAsyncReadyCallback  callback,
+                                   gpointer             user_data)
+{
+  g_autoptr (GTask) task = NULL;
+  g_autoptr (GstPad) pad = NULL;
+  FrameResult *result = NULL;
+
+  g_return_if_fail (KASASA_IS_SCREENCAST (self));
+
+  task = g_task_new (self, NULL, callback, user_data);
+  g_task_set_source_tag (task, kasasa_screencast_get_frame_async);
+
+  if (!is_running (self))
+    {
+      g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_NOT_CONNECTED,
+                               "The screencast isn't running");
+      return;
+    }
+
+  result = g_new0 (FrameResult, 1);
+  result->texture = kasasa_screencast_get_frame (self, &result->origin);
+  if (result->texture != NULL)
+    {
+      g_task_return_pointer (task, result, frame_result_free);
       return;
     }
-  gtk_stack_set_visible_child (self->stack, GTK_WIDGET (self->picture));
+  frame_result_free (result);
 
-  self->closed_handler_id = g_signal_connect (self->session,
-                                              "closed",
-                                              G_CALLBACK (on_session_closed),
+  if (self->frame_tasks == NULL)
+    self->frame_tasks = g_ptr_array_new_with_free_func (g_object_unref);
+  g_ptr_array_add (self->frame_tasks, g_steal_pointer (&task));
+
+  // Another request is already waiting for the frame
+  if (self->frame_holding_stream)
+    return;
+
+  pad = gst_element_get_static_pad (self->branch, "sink");
+  self->frame_probe_id = gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER,
+                                            frame_request_probe_cb, self, NULL);
+  g_atomic_int_set (&self->frame_request_pending, TRUE);
+  self->frame_holding_stream = TRUE;
+  kasasa_stream_play (self->stream);
+
+  self->frame_timeout_source = g_timeout_add (FRAME_REQUEST_TIMEOUT,
+                                              on_frame_request_timeout,
                                               self);
+}
+
+GdkTexture *
+kasasa_screencast_get_frame_finish (KasasaScreencast  *self,
+                                    GAsyncResult      *result,
+                                    graphene_point_t  *origin,
+                                    GError           **error)
+{
+  FrameResult *frame = NULL;
+  GdkTexture *texture = NULL;
+
+  g_return_val_if_fail (KASASA_IS_SCREENCAST (self), NULL);
+  g_return_val_if_fail (g_task_is_valid (result, self), NULL);
+
+  frame = g_task_propagate_pointer (G_TASK (result), error);
+  if (frame == NULL)
+    return NULL;
+
+  if (origin != NULL)
+    *origin = frame->origin;
+
+  texture = g_steal_pointer (&frame->texture);
+  frame_result_free (frame);
+
+  return texture;
+}
+
+// Keep only a few frames per second, before they are scaled
+static GstPadProbeReturn
+thumbnail_probe_cb (GstPad          *pad,
+                    GstPadProbeInfo *info,
+                    gpointer         user_data)
+{
+  KasasaScreencast *self = KASASA_SCREENCAST (user_data);
+  GstClockTime pts = GST_BUFFER_PTS (GST_PAD_PROBE_INFO_BUFFER (info));
+
+  if (!GST_CLOCK_TIME_IS_VALID (pts))
+    return GST_PAD_PROBE_OK;
+
+  if (GST_CLOCK_TIME_IS_VALID (self->last_thumbnail_pts)
+      && pts >= self->last_thumbnail_pts
+      && pts - self->last_thumbnail_pts < GST_SECOND / THUMBNAIL_FRAME_RATE)
+    return GST_PAD_PROBE_DROP;
+
+  self->last_thumbnail_pts = pts;
+  return GST_PAD_PROBE_OK;
+}
+
+static GstElement *
+create_thumbnail_branch (KasasaScreencast  *self,
+                         GdkPaintable     **paintable)
+{
+  GstElement *branch = NULL, *queue = NULL, *videoscale = NULL;
+  GstElement *convert = NULL, *sink = NULL;
+  GstPad *pad = NULL;
+
+  branch = gst_bin_new (NULL);
+  queue = gst_element_factory_make ("queue", NULL);
+  self->thumbnail_videocrop = gst_element_factory_make ("videocrop", NULL);
+  videoscale = gst_element_factory_make ("videoscale", NULL);
+  self->thumbnail_filter = gst_element_factory_make ("capsfilter", NULL);
+  convert = gst_element_factory_make ("videoconvert", NULL);
+  sink = gst_element_factory_make ("gtk4paintablesink", NULL);
+
+  if (!branch || !queue || !self->thumbnail_videocrop || !videoscale
+      || !self->thumbnail_filter || !convert || !sink)
+    {
+      g_warning ("Not all elements could be created.");
+      self->thumbnail_videocrop = NULL;
+      self->thumbnail_filter = NULL;
+      return NULL;
+    }
+
+  // Frames that can't be scaled in time are dropped
+  g_object_set (queue,
+                "max-size-buffers", 1,
+                "max-size-bytes", 0,
+                "max-size-time", (guint64) 0,
+                "leaky", 2,               // downstream: drop the oldest frame
+                NULL);
+
+  gst_bin_add_many (GST_BIN (branch), queue, self->thumbnail_videocrop, videoscale,
+                    self->thumbnail_filter, convert, sink, NULL);
+  if (!gst_element_link_many (queue, self->thumbnail_videocrop, videoscale,
+                              self->thumbnail_filter, convert, sink, NULL))
+    {
+      g_warning ("Elements could not be linked.");
+      gst_object_unref (branch);
+      self->thumbnail_videocrop = NULL;
+      self->thumbnail_filter = NULL;
+      return NULL;
+    }
+
+  pad = gst_element_get_static_pad (queue, "sink");
+  gst_element_add_pad (branch, gst_ghost_pad_new ("sink", pad));
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER,
+                     thumbnail_probe_cb, self, NULL);
+  gst_object_unref (pad);
+
+  g_object_get (sink,
+                "paintable", paintable,
+                NULL);
+
+  return branch;
+}
+
+static void
+stop_thumbnail (KasasaScreencast *self)
+{
+  if (self->thumbnail_branch == NULL)
+    return;
+
+  kasasa_stream_remove_branch (self->stream, self->thumbnail_branch);
+  kasasa_stream_pause (self->stream);
+  self->thumbnail_branch = NULL;
+  self->thumbnail_videocrop = NULL;
+  self->thumbnail_filter = NULL;
+
+  // The full resolution branch is only resumed if the thumbnail suspended it
+  if (self->thumbnail_suspended)
+    {
+      self->thumbnail_suspended = FALSE;
+      g_atomic_int_set (&self->suspended, FALSE);
+      g_atomic_int_set (&self->snapshot_pending, TRUE);
+      update_stream_hold (self);
+    }
+}
+
+static void
+detach_stream (KasasaScreencast *self)
+{
+  if (self->cropping_source > 0)
+    {
+      g_source_remove (self->cropping_source);
+      self->cropping_source = 0;
+    }
+
+  // The refresh may have been set on a page whose stream was already detached
+  g_clear_handle_id (&self->refresh_source, g_source_remove);
+  g_atomic_int_set (&self->refresh_interval, 0);
+
+  if (self->stream == NULL)
+    {
+      g_clear_handle_id (&self->watch_source, g_source_remove);
+      g_clear_handle_id (&self->watch_frame_timeout_source, g_source_remove);
+      return;
+    }
+
+  g_signal_handlers_disconnect_by_data (self->stream, self);
+
+  complete_frame_requests (self, NULL);
+  stop_thumbnail (self);
+  stop_watching (self);
+  self->watching = FALSE;
+
+  if (self->holding_stream)
+    {
+      kasasa_stream_pause (self->stream);
+      self->holding_stream = FALSE;
+    }
+  if (!self->trimmed)
+    kasasa_stream_keep_last_sample (self->stream, FALSE);
+
+  // The stream is torn down with its last screencast
+  kasasa_stream_remove_branch (self->stream, self->branch);
+  self->branch = NULL;
+  self->queue = NULL;
+  self->videocrop = NULL;
+  self->crop_meta = FALSE;
+  self->sink = NULL;
+  g_clear_object (&self->stream);
+
+  gtk_picture_set_paintable (self->picture, NULL);
+}
+
+/*
+ * Show a stream, which may also be shown by other screencasts; each one has
+ * its own crop and sink
+ */
+void
+kasasa_screencast_show_stream (KasasaScreencast *self,
+                               KasasaStream     *stream)
+{
+  g_return_if_fail (KASASA_IS_SCREENCAST (self));
+  g_return_if_fail (KASASA_IS_STREAM (stream));
+
+  detach_stream (self);
+
+  self->branch = create_branch (self);
+  if (self->branch == NULL)
+    return;
+
+  if (!kasasa_stream_add_branch (stream, self->branch))
+    {
+      self->branch = NULL;
+      self->queue = NULL;
+      self->videocrop = NULL;
+      self->crop_meta = FALSE;
+      self->sink = NULL;
+      gtk_picture_set_paintable (self->picture, NULL);
+      return;
+    }
+
+  self->stream = g_object_ref (stream);
+  g_atomic_int_set (&self->suspended, FALSE);
+  self->trimmed = FALSE;
+  self->fixed_region = FALSE;
+  g_atomic_int_set (&self->reset_checksum, TRUE);
+  kasasa_stream_keep_last_sample (self->stream, TRUE);
+  update_stream_hold (self);
+
+  g_signal_connect (self->stream, "eos",
+                    G_CALLBACK (on_stream_eos), self);
+  g_signal_connect (self->stream, "error",
+                    G_CALLBACK (on_stream_error), self);
+  g_signal_connect (self->stream, "reconnected",
+                    G_CALLBACK (on_stream_reconnected), self);
+
+  gtk_stack_set_visible_child (self->stack, self->offload);
 
   g_timeout_add_once (FIRST_CROP_CHECK_INTERVAL, compute_first_crop_values, self);
   self->cropping_source = g_timeout_add_seconds (CROP_CHEK_INTERVAL,
@@ -478,28 +2052,150 @@ kasasa_screencast_show (KasasaScreencast *self,
                                                  self);
 }
 
-static void
-kasasa_screencast_dispose (GObject *object)
+/*
+ * Show a small, low frame rate rendition of the screencast, e.g. in the window
+ * miniature; the full resolution branch stops receiving frames until
+ * kasasa_screencast_stop_thumbnail () is called. 'size' is the smaller side,
+ * in pixels. Returns NULL if the screencast isn't running
+ */
+GdkPaintable *
+kasasa_screencast_start_thumbnail (KasasaScreencast *self,
+                                   gint              size)
 {
-  KasasaScreencast *self = KASASA_SCREENCAST (object);
+  GdkPaintable *paintable = NULL;
+
+  g_return_val_if_fail (KASASA_IS_SCREENCAST (self), NULL);
+  g_return_val_if_fail (size > 0, NULL);
+
+  if (!is_running (self) || self->thumbnail_branch != NULL)
+    return NULL;
+
+  self->thumbnail_branch = create_thumbnail_branch (self, &paintable);
+  if (self->thumbnail_branch == NULL)
+    return NULL;
 
-  if (self->pipeline)
+  self->thumbnail_size = size;
+  self->last_thumbnail_pts = GST_CLOCK_TIME_NONE;
+  update_thumbnail (self);
+
+  if (!kasasa_stream_add_branch (self->stream, self->thumbnail_branch))
     {
-      gst_element_set_state (self->pipeline, GST_STATE_NULL);
-      gst_object_unref (self->pipeline);
-      self->pipeline = NULL;
+      self->thumbnail_branch = NULL;
+      self->thumbnail_videocrop = NULL;
+      self->thumbnail_filter = NULL;
+      g_clear_object (&paintable);
+      return NULL;
     }
 
-  if (self->session)
+  kasasa_stream_play (self->stream);
+
+  if (!self->suspended)
     {
-      g_signal_handler_disconnect (self->session, self->closed_handler_id);
-      xdp_session_close (self->session);
+      self->thumbnail_suspended = TRUE;
+      g_atomic_int_set (&self->suspended, TRUE);
+      update_stream_hold (self);
+    }
+
+  return paintable;
+}
+
+void
+kasasa_screencast_stop_thumbnail (KasasaScreencast *self)
+{
+  g_return_if_fail (KASASA_IS_SCREENCAST (self));
 
-      g_clear_object (&self->session);
+  stop_thumbnail (self);
+}
+
+/*
+ * Show only a region of the whole frame, in its coordinates (see the origin
+ * returned by kasasa_screencast_get_frame ()); the window isn't auto cropped
+ * anymore. The region is cropped at the start of the screencast's branch, so
+ * only its pixels are converted and uploaded
+ */
+void
+kasasa_screencast_set_region (KasasaScreencast      *self,
+                              const graphene_rect_t *region)
+{
+  g_autoptr (GstSample) sample = NULL;
+  const GstStructure *structure = NULL;
+  GstCaps *caps = NULL;
+  gint width = 0, height = 0;
+  gint left, top, region_width, region_height;
+
+  g_return_if_fail (KASASA_IS_SCREENCAST (self));
+  g_return_if_fail (region != NULL);
+
+  if (!is_running (self))
+    return;
+
+  sample = kasasa_stream_get_last_sample (self->stream);
+  if (sample == NULL || (caps = gst_sample_get_caps (sample)) == NULL)
+    {
+      g_warning ("No frame to select a region from");
+      return;
     }
 
-  if (self->cropping_source > 0)
-    g_source_remove (self->cropping_source);
+  structure = gst_caps_get_structure (caps, 0);
+  gst_structure_get_int (structure, "width", &width);
+  gst_structure_get_int (structure, "height", &height);
+
+  left = CLAMP ((gint) region->origin.x, 0, width - 1);
+  top = CLAMP ((gint) region->origin.y, 0, height - 1);
+  region_width = CLAMP ((gint) region->size.width, 1, width - left);
+  region_height = CLAMP ((gint) region->size.height, 1, height - top);
+
+  self->fixed_region = TRUE;
+  self->crop[CROP_TOP] = top;
+  self->crop[CROP_RIGHT] = width - left - region_width;
+  self->crop[CROP_BOTTOM] = height - top - region_height;
+  self->crop[CROP_LEFT] = left;
+
+  g_debug ("Region crop values: top: %d, bottom: %d, left: %d, right: %d",
+           self->crop[CROP_TOP], self->crop[CROP_BOTTOM],
+           self->crop[CROP_LEFT], self->crop[CROP_RIGHT]);
+
+  new_dimension (self, region_width, region_height);
+  set_crop (self);
+}
+
+// Show the stream of a session; the session is owned by the stream
+void
+kasasa_screencast_show (KasasaScreencast *self,
+                        XdpSession       *session,
+                        gint              fd,
+                        guint             node_id)
+
+{
+  g_autoptr (KasasaStream) stream = NULL;
+
+  g_return_if_fail (KASASA_IS_SCREENCAST (self));
+
+  stream = kasasa_stream_new (session, fd, node_id);
+  if (stream == NULL)
+    return;
+
+  kasasa_screencast_show_stream (self, stream);
+}
+
+// Returns the stream shown, or NULL
+KasasaStream *
+kasasa_screencast_get_stream (KasasaScreencast *self)
+{
+  g_return_val_if_fail (KASASA_IS_SCREENCAST (self), NULL);
+
+  return self->stream;
+}
+
+static void
+kasasa_screencast_dispose (GObject *object)
+{
+  KasasaScreencast *self = KASASA_SCREENCAST (object);
+
+  kasasa_memory_budget_unregister (kasasa_memory_budget_get_default (),
+                                   KASASA_CONTENT (self));
+
+  detach_stream (self);
 
   G_OBJECT_CLASS (kasasa_screencast_parent_class)->dispose (object);
 }
@@ -509,6 +2205,10 @@ kasasa_screencast_content_interface_init (KasasaContentInterface *iface)
 {
   iface->get_dimensions = kasasa_screencast_get_dimensions;
   iface->finish = kasasa_screencast_finish;
+  iface->suspend = kasasa_screencast_suspend;
+  iface->resume = kasasa_screencast_resume;
+  iface->trim_memory = kasasa_screencast_trim_memory;
+  iface->get_memory_usage = kasasa_screencast_get_memory_usage;
 }
 
 static void
@@ -516,8 +2216,6 @@ kasasa_screencast_class_init (KasasaScreencastClass *klass)
 {
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
 
-  gst_init (NULL, NULL);
-
   // Signals
   obj_signals[SIGNAL_NEW_DIMENSION] =
     g_signal_new ("new-dimension",
@@ -541,13 +2239,36 @@ kasasa_screencast_class_init (KasasaScreencastClass *klass)
                   G_TYPE_NONE,            // no return value
                   0);                     // no argument
 
+  obj_signals[SIGNAL_CHANGED] =
+    g_signal_new ("changed",
+                  KASASA_TYPE_SCREENCAST,
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL, NULL,
+                  NULL,
+                  G_TYPE_NONE,            // no return value
+                  0);                     // no argument
+
+  // The stream ended, and the user asked to restore its session
+  obj_signals[SIGNAL_RECONNECT] =
+    g_signal_new ("reconnect",
+                  KASASA_TYPE_SCREENCAST,
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL, NULL,
+                  NULL,
+                  G_TYPE_NONE,            // no return value
+                  0);                     // no argument
+
   object_class->dispose = kasasa_screencast_dispose;
 }
 
 static void
 kasasa_screencast_init (KasasaScreencast *self)
 {
-  self->pipeline = NULL;
+  self->last_frame_pts = GST_CLOCK_TIME_NONE;
+  self->last_shown_pts = GST_CLOCK_TIME_NONE;
+  self->last_thumbnail_pts = GST_CLOCK_TIME_NONE;
 
   // Initial dimension to avoid 0 value
   self->dimension[DIMENSION_WIDTH] = DEFAULT_WIDTH;
@@ -561,14 +2282,35 @@ kasasa_screencast_init (KasasaScreencast *self)
                                  "screencast-recorded-symbolic");
   adw_status_page_set_title (self->no_screencast_page, _("No screencast"));
   gtk_widget_add_css_class (GTK_WIDGET (self->no_screencast_page), "compact");
+
+  self->reconnect_button = gtk_button_new_with_label (_("Reconnect"));
+  gtk_widget_set_halign (self->reconnect_button, GTK_ALIGN_CENTER);
+  gtk_widget_add_css_class (self->reconnect_button, "pill");
+  gtk_widget_add_css_class (self->reconnect_button, "suggested-action");
+  gtk_widget_set_visible (self->reconnect_button, FALSE);
+  g_signal_connect (self->reconnect_button, "clicked",
+                    G_CALLBACK (on_reconnect_button_clicked), self);
+  adw_status_page_set_child (self->no_screencast_page, self->reconnect_button);
   gtk_stack_add_child (self->stack, GTK_WIDGET (self->no_screencast_page));
 
   // Page 2 - Screencast
+  // GTK composites the frames itself when offloading isn't possible, e.g. for
+  // memory textures or while the window opacity is lowered
   self->picture = GTK_PICTURE (gtk_picture_new ());
+  self->offload = gtk_graphics_offload_new (GTK_WIDGET (self->picture));
+  // Frames are opaque: a black background lets the subsurface be opaque too
+  gtk_graphics_offload_set_black_background (GTK_GRAPHICS_OFFLOAD (self->offload), TRUE);
   gtk_widget_set_valign (GTK_WIDGET (self), GTK_ALIGN_END);
-  gtk_stack_add_child (self->stack, GTK_WIDGET (self->picture));
+  gtk_stack_add_child (self->stack, self->offload);
 
   adw_bin_set_child (ADW_BIN (self), GTK_WIDGET (self->stack));
+
+  g_signal_connect_object (kasasa_settings_get_default (), "changed::pipeline-profile",
+                           G_CALLBACK (on_pipeline_profile_changed),
+                           self, 0);
+
+  kasasa_memory_budget_register (kasasa_memory_budget_get_default (),
+                                 KASASA_CONTENT (self));
 }
 
 KasasaScreencast *
@@ -24,6 +24,7 @@
 #include <libportal/portal.h>
 
 #include "kasasa-content.h"
+#include "kasasa-stream.h"
 
 G_BEGIN_DECLS
 
@@ -32,9 +33,37 @@ G_BEGIN_DECLS
 G_DECLARE_FINAL_TYPE (KasasaScreencast, kasasa_screencast, KASASA, SCREENCAST, AdwBin)
 
 KasasaScreencast *kasasa_screencast_new (void);
+void kasasa_screencast_preload (void);
+void kasasa_screencast_ensure_gstreamer (void);
 void kasasa_screencast_show (KasasaScreencast *screencast,
                              XdpSession       *session,
                              gint              fd,
                              guint             node_id);
+void kasasa_screencast_show_stream (KasasaScreencast *screencast,
+                                    KasasaStream     *stream);
+KasasaStream *kasasa_screencast_get_stream (KasasaScreencast *screencast);
+gboolean kasasa_screencast_is_running (KasasaScreencast *screencast);
+void kasasa_screencast_set_region (KasasaScreencast      *screencast,
+                                   const graphene_rect_t *region);
+void kasasa_screencast_set_watching (KasasaScreencast *screencast,
+                                     gboolean          watching);
+gboolean kasasa_screencast_get_watching (KasasaScreencast *screencast);
+GdkTexture *kasasa_screencast_get_frame (KasasaScreencast *screencast,
+                                         graphene_point_t *origin);
+void kasasa_screencast_get_frame_async (KasasaScreencast    *screencast,
+                                        GAsyncReadyCallback  callback,
+                                        gpointer             user_data);
+GdkTexture *kasasa_screencast_get_frame_finish (KasasaScreencast  *screencast,
+                                                GAsyncResult      *result,
+                                                graphene_point_t  *origin,
+                                                GError           **error);
+void kasasa_screencast_set_refresh_interval (KasasaScreencast *screencast,
+                                             guint             refresh_interval);
+guint kasasa_screencast_get_refresh_interval (KasasaScreencast *screencast);
+void kasasa_screencast_set_max_frame_rate (KasasaScreencast *screencast,
+                                           guint             max_frame_rate);
+GdkPaintable *kasasa_screencast_start_thumbnail (KasasaScreencast *screencast,
+                                                 gint              size);
+void kasasa_screencast_stop_thumbnail (KasasaScreencast *screencast);
 
 G_END_DECLS
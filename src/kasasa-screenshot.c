@@ -20,6 +20,10 @@
 
 #include "kasasa-screenshot.h"
 #include "kasasa-window.h"
+#include "kasasa-memory-budget.h"
+
+// Scale of the texture shown while degraded by the memory budget
+#define DEGRADED_TEXTURE_SCALE 0.5
 
 struct _KasasaScreenshot
 {
@@ -27,12 +31,20 @@ struct _KasasaScreenshot
 
   /* Instance variables */
   GFile                  *file;
+  // Encoded image, so it can be decoded again without reading the file
+  GBytes                 *encoded;
+  GdkTexture             *texture;
+  gboolean                degraded;
+  GCancellable           *decode_cancellable;
+  // Shown instead of the texture when the screenshot is a region of a capture
+  KasasaTextureRegion    *region;
   GtkPicture             *picture;
   gint                    image_height;
   gint                    image_width;
 };
 
 static void kasasa_screenshot_content_interface_init (KasasaContentInterface *iface);
+static void ensure_texture (KasasaScreenshot *self);
 
 G_DEFINE_TYPE_WITH_CODE (KasasaScreenshot, kasasa_screenshot, ADW_TYPE_BIN,
                          G_IMPLEMENT_INTERFACE (KASASA_TYPE_CONTENT,
@@ -45,6 +57,21 @@ kasasa_screenshot_get_file (KasasaScreenshot *self)
   return self->file;
 }
 
+// Returns a new reference to the texture of the screenshot, restoring its full
+// quality if needed
+GdkTexture *
+kasasa_screenshot_get_texture (KasasaScreenshot *self)
+{
+  g_return_val_if_fail (KASASA_IS_SCREENSHOT (self), NULL);
+
+  if (self->region != NULL)
+    return kasasa_texture_region_to_texture (self->region);
+
+  ensure_texture (self);
+
+  return (self->texture != NULL) ? g_object_ref (self->texture) : NULL;
+}
+
 static void
 kasasa_screenshot_get_dimensions (KasasaContent *content,
                                   gint          *height,
@@ -126,11 +153,29 @@ search_and_trash_image (const gchar *directory_name,
   return FALSE;
 }
 
+// Search the screenshot on the pictures directory and trash it; returns FALSE if
+// not trashed
+gboolean
+kasasa_screenshot_trash_file (GFile *file)
+{
+  g_autofree gchar *base_name = NULL;
+
+  // Get the image base name
+  if (file == NULL
+      || (base_name = g_file_get_basename (file)) == NULL)
+    {
+      g_warning ("Error while deleting screenshot: no reference to image");
+      return FALSE;
+    }
+
+  return search_and_trash_image (g_get_user_special_dir (G_USER_DIRECTORY_PICTURES),
+                                 base_name);
+}
+
 static void
 kasasa_screenshot_finish (KasasaContent *content)
 {
   KasasaWindow *window = NULL;
-  g_autofree gchar *base_name = NULL;
   KasasaScreenshot *self = NULL;
 
   g_return_if_fail (KASASA_IS_SCREENSHOT (content));
@@ -139,25 +184,286 @@ kasasa_screenshot_finish (KasasaContent *content)
 
   window = kasasa_window_get_window_reference (GTK_WIDGET (self));
 
-  // Return if auto trashing screenshot is not enabled
-  if (kasasa_window_get_trash_button_active (window) == FALSE)
+  // Return if auto trashing screenshot is not enabled, or if there's no file
+  // (retaken from a window stream)
+  if (kasasa_window_get_trash_button_active (window) == FALSE
+      || self->file == NULL)
     return;
 
   g_debug ("Auto trashing screenshot...");
 
-  // Get the image base name
-  if (self->file == NULL
-      || (base_name = g_file_get_basename (self->file)) == NULL)
+  if (kasasa_screenshot_trash_file (self->file))
     {
-      g_warning ("Error while deleting screenshot: no reference to image");
+      gtk_picture_set_paintable (self->picture, NULL);
+      g_clear_object (&self->texture);
+      g_clear_pointer (&self->encoded, g_bytes_unref);
+    }
+
+  return;
+}
+
+// Regions account their share of the texture shared with the other regions
+static void
+set_region (KasasaScreenshot    *self,
+            KasasaTextureRegion *region)
+{
+  if (self->region == region)
+    return;
+
+  if (self->region != NULL)
+    kasasa_texture_region_set_shown (self->region, FALSE);
+
+  g_set_object (&self->region, region);
+
+  if (self->region != NULL)
+    kasasa_texture_region_set_shown (self->region, TRUE);
+}
+
+static void
+set_texture (KasasaScreenshot *self,
+             GdkTexture       *texture)
+{
+  // Explicity unset the previous image: for some reason the old image doesn't get
+  // replaced if the new image have the same size
+  gtk_picture_set_paintable (self->picture, NULL);
+
+  g_set_object (&self->texture, texture);
+
+  if (self->texture != NULL)
+    gtk_picture_set_paintable (self->picture, GDK_PAINTABLE (self->texture));
+}
+
+// Decode the image once and show the resulting texture
+static void
+decode_texture (KasasaScreenshot *self)
+{
+  g_autoptr (GError) error = NULL;
+  g_autoptr (GdkTexture) texture = NULL;
+
+  self->degraded = FALSE;
+
+  if (self->encoded == NULL)
+    {
+      set_texture (self, NULL);
       return;
     }
 
-  if (search_and_trash_image (g_get_user_special_dir (G_USER_DIRECTORY_PICTURES),
-                              base_name))
-    gtk_picture_set_file (self->picture, NULL);
+  texture = gdk_texture_new_from_bytes (self->encoded, &error);
+  if (error != NULL)
+    {
+      g_warning ("Couldn't load screenshot: %s", error->message);
+      self->image_height = self->image_width = 0;
+      set_texture (self, NULL);
+      return;
+    }
 
-  return;
+  // Save image information
+  self->image_height = gdk_texture_get_height (texture);
+  self->image_width = gdk_texture_get_width (texture);
+
+  set_texture (self, texture);
+
+  kasasa_memory_budget_queue_check (kasasa_memory_budget_get_default ());
+}
+
+// The file is only read if there's no encoded image yet (e.g. restored)
+typedef struct
+{
+  GFile                  *file;
+  GBytes                 *encoded;
+} DecodeData;
+
+static void
+decode_data_free (gpointer user_data)
+{
+  DecodeData *data = user_data;
+
+  g_clear_object (&data->file);
+  g_clear_pointer (&data->encoded, g_bytes_unref);
+  g_free (data);
+}
+
+static void
+decode_texture_thread (GTask        *task,
+                       gpointer      source_object,
+                       gpointer      task_data,
+                       GCancellable *cancellable)
+{
+  DecodeData *data = task_data;
+  GdkTexture *texture = NULL;
+  GError *error = NULL;
+
+  if (data->encoded == NULL)
+    {
+      data->encoded = g_file_load_bytes (data->file, cancellable, NULL, &error);
+      if (data->encoded == NULL)
+        {
+          g_task_return_error (task, error);
+          return;
+        }
+    }
+
+  // Decoding textures from bytes is threadsafe
+  texture = gdk_texture_new_from_bytes (data->encoded, &error);
+
+  if (texture == NULL)
+    g_task_return_error (task, error);
+  else
+    g_task_return_pointer (task, texture, g_object_unref);
+}
+
+static void
+on_texture_decoded (GObject      *source_object,
+                    GAsyncResult *res,
+                    gpointer      user_data)
+{
+  KasasaScreenshot *self = KASASA_SCREENSHOT (source_object);
+  DecodeData *data = g_task_get_task_data (G_TASK (res));
+  g_autoptr (GdkTexture) texture = NULL;
+  g_autoptr (GError) error = NULL;
+
+  texture = g_task_propagate_pointer (G_TASK (res), &error);
+
+  // Cancelled when the image was replaced or the screenshot disposed
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    return;
+
+  g_clear_object (&self->decode_cancellable);
+
+  // Keep the image read from the file, so it's not read again
+  if (self->encoded == NULL && data->encoded != NULL)
+    self->encoded = g_bytes_ref (data->encoded);
+
+  if (error != NULL)
+    {
+      g_warning ("Couldn't load screenshot: %s", error->message);
+      return;
+    }
+
+  // The image may have been decoded synchronously in the meantime
+  if (self->texture != NULL && !self->degraded)
+    return;
+
+  self->image_height = gdk_texture_get_height (texture);
+  self->image_width = gdk_texture_get_width (texture);
+  self->degraded = FALSE;
+  set_texture (self, texture);
+
+  kasasa_memory_budget_queue_check (kasasa_memory_budget_get_default ());
+}
+
+static void
+cancel_prefetch (KasasaScreenshot *self)
+{
+  if (self->decode_cancellable == NULL)
+    return;
+
+  g_cancellable_cancel (self->decode_cancellable);
+  g_clear_object (&self->decode_cancellable);
+}
+
+/*
+ * Decode the image in a thread if it was trimmed or degraded (or read it first,
+ * if it was restored), so it's ready by the time it's needed
+ */
+void
+kasasa_screenshot_prefetch (KasasaScreenshot *self)
+{
+  g_autoptr (GTask) task = NULL;
+  DecodeData *data = NULL;
+
+  g_return_if_fail (KASASA_IS_SCREENSHOT (self));
+
+  if ((self->encoded == NULL && self->file == NULL)
+      || (self->texture != NULL && !self->degraded)
+      || self->decode_cancellable != NULL)
+    return;
+
+  data = g_new0 (DecodeData, 1);
+  if (self->encoded != NULL)
+    data->encoded = g_bytes_ref (self->encoded);
+  else
+    data->file = g_object_ref (self->file);
+
+  self->decode_cancellable = g_cancellable_new ();
+
+  task = g_task_new (self, self->decode_cancellable, on_texture_decoded, NULL);
+  g_task_set_task_data (task, data, decode_data_free);
+  g_task_run_in_thread (task, decode_texture_thread);
+}
+
+// Decode the image synchronously if it isn't ready (e.g. to copy it)
+static void
+ensure_texture (KasasaScreenshot *self)
+{
+  g_autoptr (GError) error = NULL;
+
+  if (self->texture != NULL && !self->degraded)
+    return;
+
+  cancel_prefetch (self);
+
+  if (self->encoded == NULL && self->file != NULL)
+    {
+      self->encoded = g_file_load_bytes (self->file, NULL, NULL, &error);
+      if (error != NULL)
+        g_warning ("Couldn't read screenshot: %s", error->message);
+    }
+
+  decode_texture (self);
+}
+
+static void
+load_texture (KasasaScreenshot *self,
+              const gchar      *uri)
+{
+  g_autoptr (GError) error = NULL;
+
+  cancel_prefetch (self);
+  g_clear_object (&self->file);
+  g_clear_pointer (&self->encoded, g_bytes_unref);
+  set_region (self, NULL);
+
+  self->file = g_file_new_for_uri (uri);
+  self->encoded = g_file_load_bytes (self->file, NULL, NULL, &error);
+  if (error != NULL)
+    g_warning ("Couldn't read screenshot: %s", error->message);
+
+  decode_texture (self);
+}
+
+// Returns a copy of the texture scaled down, or NULL on failure
+static GdkTexture *
+downscale_texture (GdkTexture *texture,
+                   gdouble     scale)
+{
+  g_autoptr (GdkTextureDownloader) downloader = NULL;
+  g_autoptr (GBytes) bytes = NULL;
+  g_autoptr (GdkPixbuf) pixbuf = NULL;
+  g_autoptr (GdkPixbuf) scaled = NULL;
+  gint width = gdk_texture_get_width (texture);
+  gint height = gdk_texture_get_height (texture);
+  gsize stride;
+
+  // GdkPixbuf uses non-premultiplied RGBA
+  downloader = gdk_texture_downloader_new (texture);
+  gdk_texture_downloader_set_format (downloader, GDK_MEMORY_R8G8B8A8);
+  bytes = gdk_texture_downloader_download_bytes (downloader, &stride);
+
+  pixbuf = gdk_pixbuf_new_from_bytes (bytes, GDK_COLORSPACE_RGB, TRUE, 8,
+                                      width, height, (gint) stride);
+  scaled = gdk_pixbuf_scale_simple (pixbuf,
+                                    MAX (1, (gint) (width * scale)),
+                                    MAX (1, (gint) (height * scale)),
+                                    GDK_INTERP_BILINEAR);
+  if (scaled == NULL)
+    return NULL;
+
+  return gdk_memory_texture_new (gdk_pixbuf_get_width (scaled),
+                                 gdk_pixbuf_get_height (scaled),
+                                 GDK_MEMORY_R8G8B8A8,
+                                 gdk_pixbuf_read_pixel_bytes (scaled),
+                                 gdk_pixbuf_get_rowstride (scaled));
 }
 
 // Load the screenshot to the GtkPicture widget
@@ -166,8 +472,6 @@ kasasa_screenshot_load_screenshot (KasasaScreenshot *self,
                                    const gchar      *uri)
 {
   KasasaWindow *window = NULL;
-  g_autoptr (GError) error = NULL;
-  g_autoptr (GdkTexture) texture = NULL;
   gint height, width;
 
   g_return_if_fail (KASASA_IS_SCREENSHOT (self) || uri == NULL);
@@ -175,17 +479,7 @@ kasasa_screenshot_load_screenshot (KasasaScreenshot *self,
   if (self->file != NULL)
     kasasa_screenshot_finish (KASASA_CONTENT (self));
 
-  self->file = g_file_new_for_uri (uri);
-
-  // Save image information
-  texture = gdk_texture_new_from_file (self->file, &error);
-  self->image_height = gdk_texture_get_height (texture);
-  self->image_width = gdk_texture_get_width (texture);
-
-  // Explicity unset the previous image: for some reason the old image doesn't get
-  // replaced if the new image have the same size
-  gtk_picture_set_file (self->picture, NULL);
-  gtk_picture_set_file (self->picture, self->file);
+  load_texture (self, uri);
 
   // Compute new dimensions and resize the window
   kasasa_content_get_dimensions (KASASA_CONTENT (self), &height, &width);
@@ -193,13 +487,153 @@ kasasa_screenshot_load_screenshot (KasasaScreenshot *self,
   kasasa_window_resize_window_scaling (window, height, width);
 }
 
+/*
+ * Show a region of a shared capture; nothing is decoded nor copied. The file of
+ * the capture is shared with the other regions, so it isn't owned (nor
+ * trashed) by the screenshot
+ */
+void
+kasasa_screenshot_show_region (KasasaScreenshot    *self,
+                               KasasaTextureRegion *region)
+{
+  g_return_if_fail (KASASA_IS_SCREENSHOT (self));
+  g_return_if_fail (KASASA_IS_TEXTURE_REGION (region));
+
+  cancel_prefetch (self);
+  g_clear_object (&self->file);
+  g_clear_pointer (&self->encoded, g_bytes_unref);
+  set_texture (self, NULL);
+  self->degraded = FALSE;
+
+  set_region (self, region);
+  self->image_height = gdk_paintable_get_intrinsic_height (GDK_PAINTABLE (region));
+  self->image_width = gdk_paintable_get_intrinsic_width (GDK_PAINTABLE (region));
+
+  gtk_picture_set_paintable (self->picture, GDK_PAINTABLE (region));
+}
+
+/*
+ * Load a screenshot that was already shown before, without trashing the current
+ * one nor resizing the window. The image is read and decoded in a thread; the
+ * dimensions it had keep the size of the page meanwhile
+ */
+void
+kasasa_screenshot_restore_screenshot (KasasaScreenshot *self,
+                                      const gchar      *uri,
+                                      gint              height,
+                                      gint              width)
+{
+  g_return_if_fail (KASASA_IS_SCREENSHOT (self) || uri == NULL);
+
+  cancel_prefetch (self);
+  g_clear_object (&self->file);
+  g_clear_pointer (&self->encoded, g_bytes_unref);
+  set_region (self, NULL);
+  set_texture (self, NULL);
+  self->degraded = FALSE;
+
+  self->file = g_file_new_for_uri (uri);
+  self->image_height = height;
+  self->image_width = width;
+
+  kasasa_screenshot_prefetch (self);
+}
+
+static void
+kasasa_screenshot_resume (KasasaContent *content)
+{
+  KasasaScreenshot *self = NULL;
+
+  g_return_if_fail (KASASA_IS_SCREENSHOT (content));
+
+  self = KASASA_SCREENSHOT (content);
+
+  // Regions share a texture that is never trimmed
+  if (self->region != NULL)
+    return;
+
+  // Decode the image again if it was trimmed or degraded; it's done in a thread
+  // so that swiping through the pages doesn't stall
+  kasasa_screenshot_prefetch (self);
+}
+
+static void
+kasasa_screenshot_trim_memory (KasasaContent    *content,
+                               ContentTrimLevel  level)
+{
+  KasasaScreenshot *self = NULL;
+
+  g_return_if_fail (KASASA_IS_SCREENSHOT (content));
+
+  self = KASASA_SCREENSHOT (content);
+
+  // Regions share a texture that is never trimmed
+  if (self->region != NULL)
+    return;
+
+  if (level == CONTENT_TRIM_LEVEL_COMPLETE)
+    cancel_prefetch (self);
+
+  if (self->texture == NULL)
+    return;
+
+  if (level == CONTENT_TRIM_LEVEL_DEGRADE && !self->degraded)
+    {
+      g_autoptr (GdkTexture) scaled = NULL;
+
+      scaled = downscale_texture (self->texture, DEGRADED_TEXTURE_SCALE);
+      if (scaled == NULL)
+        return;
+
+      set_texture (self, scaled);
+      self->degraded = TRUE;
+    }
+  else if (level == CONTENT_TRIM_LEVEL_COMPLETE)
+    {
+      // Only the encoded image is kept. The image dimensions are kept too, so the
+      // window can still be resized
+      set_texture (self, NULL);
+      self->degraded = FALSE;
+    }
+}
+
+static gsize
+kasasa_screenshot_get_memory_usage (KasasaContent *content)
+{
+  KasasaScreenshot *self = NULL;
+  gsize usage = 0;
+
+  g_return_val_if_fail (KASASA_IS_SCREENSHOT (content), 0);
+
+  self = KASASA_SCREENSHOT (content);
+
+  if (self->region != NULL)
+    return kasasa_texture_region_get_memory_usage (self->region);
+
+  if (self->encoded != NULL)
+    usage += g_bytes_get_size (self->encoded);
+
+  // 4 bytes per pixel
+  if (self->texture != NULL)
+    usage += (gsize) gdk_texture_get_width (self->texture)
+             * gdk_texture_get_height (self->texture) * 4;
+
+  return usage;
+}
+
 static void
 kasasa_screenshot_dispose (GObject *object)
 {
   KasasaScreenshot *self = KASASA_SCREENSHOT (object);
 
-  if (self->file != NULL)
-    g_object_unref (self->file);
+  kasasa_memory_budget_unregister (kasasa_memory_budget_get_default (),
+                                   KASASA_CONTENT (self));
+
+  cancel_prefetch (self);
+  g_clear_object (&self->file);
+  g_clear_pointer (&self->encoded, g_bytes_unref);
+  g_clear_object (&self->texture);
+  set_region (self, NULL);
 
   G_OBJECT_CLASS (kasasa_screenshot_parent_class)->dispose (object);
 }
@@ -209,6 +643,9 @@ kasasa_screenshot_content_interface_init (KasasaContentInterface *iface)
 {
   iface->get_dimensions = kasasa_screenshot_get_dimensions;
   iface->finish = kasasa_screenshot_finish;
+  iface->resume = kasasa_screenshot_resume;
+  iface->trim_memory = kasasa_screenshot_trim_memory;
+  iface->get_memory_usage = kasasa_screenshot_get_memory_usage;
 }
 
 static void
@@ -222,9 +659,14 @@ kasasa_screenshot_class_init (KasasaScreenshotClass *klass)
 static void
 kasasa_screenshot_init (KasasaScreenshot *self)
 {
+  // Scanned out as a subsurface when possible; otherwise GTK composites the
+  // picture itself. Images may be translucent, so there's no black background
   self->picture = GTK_PICTURE (gtk_picture_new ());
-  adw_bin_set_child (ADW_BIN (self), GTK_WIDGET (self->picture));
+  adw_bin_set_child (ADW_BIN (self), gtk_graphics_offload_new (GTK_WIDGET (self->picture)));
   gtk_widget_set_valign (GTK_WIDGET (self), GTK_ALIGN_END);
+
+  kasasa_memory_budget_register (kasasa_memory_budget_get_default (),
+                                 KASASA_CONTENT (self));
 }
 
 KasasaScreenshot *
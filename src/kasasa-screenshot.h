@@ -23,6 +23,7 @@
 #include <adwaita.h>
 
 #include "kasasa-content.h"
+#include "kasasa-texture-region.h"
 
 G_BEGIN_DECLS
 
@@ -32,7 +33,16 @@ G_DECLARE_FINAL_TYPE (KasasaScreenshot, kasasa_screenshot, KASASA, SCREENSHOT, A
 
 KasasaScreenshot *kasasa_screenshot_new (void);
 GFile *kasasa_screenshot_get_file (KasasaScreenshot *screenshot);
+GdkTexture *kasasa_screenshot_get_texture (KasasaScreenshot *screenshot);
 void kasasa_screenshot_load_screenshot (KasasaScreenshot *screenshot,
                                         const gchar      *uri);
+void kasasa_screenshot_restore_screenshot (KasasaScreenshot *screenshot,
+                                           const gchar      *uri,
+                                           gint              height,
+                                           gint              width);
+void kasasa_screenshot_show_region (KasasaScreenshot    *screenshot,
+                                    KasasaTextureRegion *region);
+void kasasa_screenshot_prefetch (KasasaScreenshot *screenshot);
+gboolean kasasa_screenshot_trash_file (GFile *file);
 
 G_END_DECLS
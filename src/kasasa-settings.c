@@ -0,0 +1,154 @@
+/* kasasa-settings.c
+ *
+ * Copyright 2026 Kelvin Novais
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "kasasa-settings.h"
+
+/*
+ * KasasaSettings keeps the values of the GSettings keys in a plain struct, so
+ * hot paths (pointer motion, resizing) don't need to query GSettings. The
+ * struct is updated before the "changed" signal is emitted.
+ */
+
+// Signals
+enum
+{
+  SIGNAL_CHANGED,
+
+  N_SIGNALS
+};
+
+static guint obj_signals[N_SIGNALS];
+
+struct _KasasaSettings
+{
+  GObject                  parent_instance;
+
+  /* Instance variables */
+  GSettings               *gsettings;
+  KasasaSettingsValues     values;
+};
+
+G_DEFINE_FINAL_TYPE (KasasaSettings, kasasa_settings, G_TYPE_OBJECT)
+
+static void
+load_values (KasasaSettings *self)
+{
+  KasasaSettingsValues *values = &self->values;
+
+  values->auto_hide_menu = g_settings_get_boolean (self->gsettings, "auto-hide-menu");
+  values->controls_timeout = g_settings_get_double (self->gsettings, "controls-timeout");
+  values->change_opacity = g_settings_get_boolean (self->gsettings, "change-opacity");
+  values->opacity = g_settings_get_double (self->gsettings, "opacity");
+  values->miniaturize_window = g_settings_get_boolean (self->gsettings, "miniaturize-window");
+  values->occupy_screen = g_settings_get_int (self->gsettings, "occupy-screen");
+  values->auto_discard_window = g_settings_get_boolean (self->gsettings, "auto-discard-window");
+  values->auto_discard_window_time = g_settings_get_double (self->gsettings, "auto-discard-window-time");
+  values->auto_trash_image = g_settings_get_boolean (self->gsettings, "auto-trash-image");
+  values->screenshot_delay = g_settings_get_uint (self->gsettings, "screenshot-delay");
+  values->memory_budget_mb = g_settings_get_uint (self->gsettings, "memory-budget-mb");
+  values->fast_retake = g_settings_get_boolean (self->gsettings, "fast-retake");
+  values->pipeline_profile = g_settings_get_enum (self->gsettings, "pipeline-profile");
+}
+
+static void
+on_gsettings_changed (GSettings   *gsettings,
+                      const gchar *key,
+                      gpointer     user_data)
+{
+  KasasaSettings *self = KASASA_SETTINGS (user_data);
+
+  // Reading all the keys is cheap, and this only happens when the user changes
+  // a preference
+  load_values (self);
+
+  g_signal_emit (self,
+                 obj_signals[SIGNAL_CHANGED],
+                 g_quark_from_string (key),
+                 key);
+}
+
+const KasasaSettingsValues *
+kasasa_settings_get_values (KasasaSettings *self)
+{
+  g_return_val_if_fail (KASASA_IS_SETTINGS (self), NULL);
+
+  return &self->values;
+}
+
+GSettings *
+kasasa_settings_get_gsettings (KasasaSettings *self)
+{
+  g_return_val_if_fail (KASASA_IS_SETTINGS (self), NULL);
+
+  return self->gsettings;
+}
+
+// Returns the instance shared by all windows; it lives until the app exits
+KasasaSettings *
+kasasa_settings_get_default (void)
+{
+  static KasasaSettings *default_settings = NULL;
+
+  if (default_settings == NULL)
+    default_settings = g_object_new (KASASA_TYPE_SETTINGS, NULL);
+
+  return default_settings;
+}
+
+static void
+kasasa_settings_dispose (GObject *object)
+{
+  KasasaSettings *self = KASASA_SETTINGS (object);
+
+  g_clear_object (&self->gsettings);
+
+  G_OBJECT_CLASS (kasasa_settings_parent_class)->dispose (object);
+}
+
+static void
+kasasa_settings_class_init (KasasaSettingsClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  // Signals
+  obj_signals[SIGNAL_CHANGED] =
+    g_signal_new ("changed",
+                  KASASA_TYPE_SETTINGS,
+                  G_SIGNAL_RUN_LAST | G_SIGNAL_DETAILED,
+                  0,
+                  NULL, NULL,
+                  NULL,
+                  G_TYPE_NONE,            // no return value
+                  1,                      // 1 argument
+                  G_TYPE_STRING);         // key
+
+  object_class->dispose = kasasa_settings_dispose;
+}
+
+static void
+kasasa_settings_init (KasasaSettings *self)
+{
+  self->gsettings = g_settings_new ("io.github.kelvinnovais.Kasasa");
+
+  load_values (self);
+
+  g_signal_connect (self->gsettings, "changed",
+                    G_CALLBACK (on_gsettings_changed), self);
+}
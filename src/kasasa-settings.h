@@ -0,0 +1,61 @@
+/* kasasa-settings.h
+ *
+ * Copyright 2026 Kelvin Novais
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+// Same values as the PipelineProfile enum of the GSchema
+typedef enum
+{
+  KASASA_PIPELINE_PROFILE_LOW_LATENCY,
+  KASASA_PIPELINE_PROFILE_BALANCED,
+  KASASA_PIPELINE_PROFILE_LOW_POWER,
+} KasasaPipelineProfile;
+
+// Snapshot of the GSettings keys; see the GSchema for their meaning
+typedef struct
+{
+  gboolean              auto_hide_menu;
+  gdouble               controls_timeout;
+  gboolean              change_opacity;
+  gdouble               opacity;
+  gboolean              miniaturize_window;
+  gint                  occupy_screen;
+  gboolean              auto_discard_window;
+  gdouble               auto_discard_window_time;
+  gboolean              auto_trash_image;
+  guint                 screenshot_delay;
+  guint                 memory_budget_mb;
+  gboolean              fast_retake;
+  KasasaPipelineProfile pipeline_profile;
+} KasasaSettingsValues;
+
+#define KASASA_TYPE_SETTINGS (kasasa_settings_get_type ())
+
+G_DECLARE_FINAL_TYPE (KasasaSettings, kasasa_settings, KASASA, SETTINGS, GObject)
+
+KasasaSettings *kasasa_settings_get_default (void);
+const KasasaSettingsValues *kasasa_settings_get_values (KasasaSettings *settings);
+GSettings *kasasa_settings_get_gsettings (KasasaSettings *settings);
+
+G_END_DECLS
@@ -0,0 +1,674 @@
+/* kasasa-stream.c
+ *
+ * Copyright 2026 Kelvin Novais
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "kasasa-stream.h"
+#include "kasasa-screencast.h"
+
+/*
+ * KasasaStream receives a PipeWire stream once and shares it between all the
+ * screencasts showing it; each of them adds a branch with its own crop and
+ * sink. The stream is torn down when the last screencast drops its reference.
+ *
+ * Streams are only shared by handing them explicitly to another screencast
+ * (duplicated pages, selected regions). Each portal session gets its own
+ * stream: PipeWire node ids are per session and get recycled, so two sessions
+ * of the same window can't be matched.
+ *
+ * When the stream ends, the pipeline is kept in READY with its branches, so
+ * that it can be reconnected to a new session restored from the token of the
+ * previous one, without rebuilding any element.
+ *
+ * pipewiresrc ! tee ! queue ! fakesink (last sample)
+ *                   ! branch (one for each screencast)
+ */
+
+struct _KasasaStream
+{
+  GObject                  parent_instance;
+
+  /* Instance variables */
+  XdpSession              *session;
+  gulong                   closed_handler_id;
+  guint                    node_id;
+  gchar                   *restore_token;
+  // The session was closed or the stream reached its end
+  gboolean                 ended;
+  GstElement              *pipeline;
+  GstElement              *source;
+  GstElement              *tee;
+  GstElement              *fakesink;
+  // Branches not suspended; the pipeline is paused when there's none
+  guint                    n_playing;
+  // Branches that need the last sample of the fakesink
+  guint                    n_keeping_last_sample;
+};
+
+G_DEFINE_FINAL_TYPE (KasasaStream, kasasa_stream, G_TYPE_OBJECT)
+
+// Signals
+enum
+{
+  SIGNAL_EOS,
+  SIGNAL_ERROR,
+  SIGNAL_RECONNECTED,
+
+  N_SIGNALS
+};
+
+static guint obj_signals[N_SIGNALS];
+
+typedef struct
+{
+  KasasaStream            *stream;
+  GstElement              *branch;
+  GstPad                  *tee_pad;
+} BranchRemoval;
+
+// Keep the pipeline for a reconnection; the node may be reused by PipeWire
+static void
+end_stream (KasasaStream *self)
+{
+  if (self->ended)
+    return;
+
+  self->ended = TRUE;
+  gst_element_set_state (self->pipeline, GST_STATE_READY);
+
+  if (self->session)
+    {
+      g_clear_signal_handler (&self->closed_handler_id, self->session);
+      xdp_session_close (self->session);
+      g_clear_object (&self->session);
+    }
+
+  g_signal_emit (self,
+                 obj_signals[SIGNAL_EOS],
+                 0);
+}
+
+static void
+on_session_closed (XdpSession *session,
+                   gpointer    user_data)
+{
+  KasasaStream *self = KASASA_STREAM (user_data);
+
+  g_info ("Session closed");
+
+  // Already closed
+  g_clear_signal_handler (&self->closed_handler_id, self->session);
+  g_clear_object (&self->session);
+
+  end_stream (self);
+}
+
+static void
+eos_cb (GstBus       *bus,
+        GstMessage   *msg,
+        KasasaStream *self)
+{
+  g_info ("End-Of-Stream reached");
+  end_stream (self);
+}
+
+static void
+error_cb (GstBus       *bus,
+          GstMessage   *msg,
+          KasasaStream *self)
+{
+  g_autoptr (GError) error = NULL;
+  g_autofree gchar *debug_info = NULL;
+
+  gst_message_parse_error (msg, &error, &debug_info);
+  g_warning ("Error received from element %s: %s",
+             GST_OBJECT_NAME (msg->src), error->message);
+  g_warning ("Debugging information: %s", debug_info ? debug_info : "none");
+
+  // Kept in READY, as play () would resume the failed pipeline otherwise
+  self->ended = TRUE;
+  gst_element_set_state (self->pipeline, GST_STATE_READY);
+
+  g_signal_emit (self,
+                 obj_signals[SIGNAL_ERROR],
+                 0,
+                 error->message);
+}
+
+static gboolean
+build_pipeline (KasasaStream *self,
+                gint          fd)
+{
+  g_autofree gchar *node_id_str = NULL;
+  GstElement *queue = NULL;
+  GstBus *bus = NULL;
+
+  kasasa_screencast_ensure_gstreamer ();
+
+  node_id_str = g_strdup_printf ("%u", self->node_id);
+
+  // Create the elements
+  self->pipeline = gst_pipeline_new ("pipeline");
+  self->source = gst_element_factory_make ("pipewiresrc", "pipewire_element");
+  self->tee = gst_element_factory_make ("tee", "tee");
+  queue = gst_element_factory_make ("queue", "fakesink_queue");
+  // Create a fakesink to retrieve original frames
+  self->fakesink = gst_element_factory_make ("fakesink", "fakesink");
+
+  if (!self->pipeline || !self->source || !self->tee || !queue || !self->fakesink)
+    {
+      g_warning ("Not all elements could be created.");
+      return FALSE;
+    }
+
+  // Set the fd and node ID
+  g_object_set (self->source,
+                "fd", fd,
+                "path", node_id_str,
+                NULL);
+
+  g_debug ("fd: %d; node_id: %s", fd, node_id_str);
+
+  // The fakesink only provides the last sample: a frame behind is enough, and
+  // older ones are dropped instead of queued
+  g_object_set (queue,
+                "max-size-buffers", 1,
+                "max-size-bytes", 0,
+                "max-size-time", (guint64) 0,
+                "leaky", 2,               // downstream: drop the oldest frame
+                NULL);
+
+  g_object_set (self->fakesink,
+                "enable-last-sample", FALSE,
+                NULL);
+
+  gst_bin_add_many (GST_BIN (self->pipeline),
+                    self->source, self->tee, queue, self->fakesink, NULL);
+  if (!gst_element_link_many (self->source, self->tee, queue, self->fakesink, NULL))
+    {
+      g_warning ("Elements could not be linked.");
+      return FALSE;
+    }
+
+  // Configure the bus
+  bus = gst_element_get_bus (self->pipeline);
+  gst_bus_add_signal_watch (bus);
+  g_signal_connect (G_OBJECT (bus), "message::error", (GCallback) error_cb, self);
+  g_signal_connect (G_OBJECT (bus), "message::eos", (GCallback) eos_cb, self);
+  gst_object_unref (bus);
+
+  // Nothing is shown until a branch is playing
+  if (gst_element_set_state (self->pipeline, GST_STATE_PAUSED) == GST_STATE_CHANGE_FAILURE)
+    {
+      g_warning ("Unable to set the pipeline to the paused state.");
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+/*
+ * Create the stream of a PipeWire node; the session is owned by the stream.
+ * Returns NULL on failure
+ */
+KasasaStream *
+kasasa_stream_new (XdpSession *session,
+                   gint        fd,
+                   guint       node_id)
+{
+  KasasaStream *self = NULL;
+
+  g_return_val_if_fail (XDP_IS_SESSION (session), NULL);
+
+  self = g_object_new (KASASA_TYPE_STREAM, NULL);
+  self->session = session;
+  self->node_id = node_id;
+  self->restore_token = xdp_session_get_restore_token (session);
+
+  if (!build_pipeline (self, fd))
+    {
+      g_object_unref (self);
+      return NULL;
+    }
+
+  self->closed_handler_id = g_signal_connect (self->session,
+                                              "closed",
+                                              G_CALLBACK (on_session_closed),
+                                              self);
+
+  return self;
+}
+
+guint
+kasasa_stream_get_node_id (KasasaStream *self)
+{
+  g_return_val_if_fail (KASASA_IS_STREAM (self), 0);
+
+  return self->node_id;
+}
+
+// Link a bin with a "sink" pad to the tee; it's added paused
+gboolean
+kasasa_stream_add_branch (KasasaStream *self,
+                          GstElement   *branch)
+{
+  g_autoptr (GstPad) tee_pad = NULL;
+  g_autoptr (GstPad) sink_pad = NULL;
+
+  g_return_val_if_fail (KASASA_IS_STREAM (self), FALSE);
+  g_return_val_if_fail (GST_IS_BIN (branch), FALSE);
+
+  gst_bin_add (GST_BIN (self->pipeline), branch);
+
+  tee_pad = gst_element_request_pad_simple (self->tee, "src_%u");
+  sink_pad = gst_element_get_static_pad (branch, "sink");
+
+  if (gst_pad_link (tee_pad, sink_pad) != GST_PAD_LINK_OK)
+    {
+      g_warning ("Elements could not be linked.");
+      gst_element_release_request_pad (self->tee, tee_pad);
+      gst_bin_remove (GST_BIN (self->pipeline), branch);
+      return FALSE;
+    }
+
+  gst_element_sync_state_with_parent (branch);
+
+  return TRUE;
+}
+
+static gboolean
+finish_branch_removal (gpointer user_data)
+{
+  BranchRemoval *removal = user_data;
+
+  gst_element_release_request_pad (removal->stream->tee, removal->tee_pad);
+  gst_element_set_state (removal->branch, GST_STATE_NULL);
+  gst_bin_remove (GST_BIN (removal->stream->pipeline), removal->branch);
+
+  gst_object_unref (removal->tee_pad);
+  gst_object_unref (removal->branch);
+  g_object_unref (removal->stream);
+  g_free (removal);
+
+  return G_SOURCE_REMOVE;
+}
+
+// Called from the streaming thread, or right away if no data is flowing
+static GstPadProbeReturn
+unlink_branch_cb (GstPad          *pad,
+                  GstPadProbeInfo *info,
+                  gpointer         user_data)
+{
+  BranchRemoval *removal = user_data;
+  g_autoptr (GstPad) sink_pad = NULL;
+
+  sink_pad = gst_element_get_static_pad (removal->branch, "sink");
+  gst_pad_unlink (pad, sink_pad);
+
+  // Elements are only removed from the main thread
+  g_main_context_invoke (NULL, finish_branch_removal, removal);
+
+  return GST_PAD_PROBE_REMOVE;
+}
+
+// Unlink a branch once no buffer is going through it, and remove it
+void
+kasasa_stream_remove_branch (KasasaStream *self,
+                             GstElement   *branch)
+{
+  g_autoptr (GstPad) sink_pad = NULL;
+  BranchRemoval *removal = NULL;
+
+  g_return_if_fail (KASASA_IS_STREAM (self));
+  g_return_if_fail (GST_IS_ELEMENT (branch));
+
+  sink_pad = gst_element_get_static_pad (branch, "sink");
+
+  removal = g_new0 (BranchRemoval, 1);
+  removal->stream = g_object_ref (self);
+  removal->branch = gst_object_ref (branch);
+  removal->tee_pad = gst_pad_get_peer (sink_pad);
+
+  if (removal->tee_pad == NULL)
+    {
+      gst_element_set_state (branch, GST_STATE_NULL);
+      gst_bin_remove (GST_BIN (self->pipeline), branch);
+      gst_object_unref (removal->branch);
+      g_object_unref (removal->stream);
+      g_free (removal);
+      return;
+    }
+
+  gst_pad_add_probe (removal->tee_pad, GST_PAD_PROBE_TYPE_IDLE,
+                     unlink_branch_cb, removal, NULL);
+}
+
+static void
+update_state (KasasaStream *self)
+{
+  // Kept in READY until reconnected
+  if (self->ended)
+    return;
+
+  gst_element_set_state (self->pipeline,
+                         (self->n_playing > 0) ? GST_STATE_PLAYING : GST_STATE_PAUSED);
+}
+
+// Each branch that is shown calls play (), and pause () when it's suspended
+void
+kasasa_stream_play (KasasaStream *self)
+{
+  g_return_if_fail (KASASA_IS_STREAM (self));
+
+  self->n_playing++;
+  if (self->n_playing == 1)
+    update_state (self);
+}
+
+void
+kasasa_stream_pause (KasasaStream *self)
+{
+  g_return_if_fail (KASASA_IS_STREAM (self));
+  g_return_if_fail (self->n_playing > 0);
+
+  self->n_playing--;
+  if (self->n_playing == 0)
+    update_state (self);
+}
+
+// Whether the stream ended, and a new session can be restored for it
+gboolean
+kasasa_stream_can_reconnect (KasasaStream *self)
+{
+  g_return_val_if_fail (KASASA_IS_STREAM (self), FALSE);
+
+  return self->ended && self->restore_token != NULL;
+}
+
+// The token is consumed: if the restored session fails, the stream is over
+static void
+fail_reconnection (KasasaStream *self,
+                   GTask        *task,
+                   GError       *error)
+{
+  g_warning ("Couldn't reconnect the stream: %s", error->message);
+
+  if (self->session)
+    {
+      xdp_session_close (self->session);
+      g_clear_object (&self->session);
+    }
+  g_clear_pointer (&self->restore_token, g_free);
+
+  g_task_return_error (task, error);
+
+  g_signal_emit (self,
+                 obj_signals[SIGNAL_EOS],
+                 0);
+}
+
+static void
+on_reconnect_session_started (GObject      *source_object,
+                              GAsyncResult *res,
+                              gpointer      user_data)
+{
+  g_autoptr (GTask) task = G_TASK (user_data);
+  KasasaStream *self = g_task_get_source_object (task);
+  g_autoptr (GVariant) session_streams = NULL;
+  g_autoptr (GVariant) stream = NULL;
+  g_autofree gchar *node_id_str = NULL;
+  GError *error = NULL;
+  gint fd;
+
+  if (!xdp_session_start_finish (XDP_SESSION (source_object), res, &error))
+    {
+      fail_reconnection (self, task, error);
+      return;
+    }
+
+  session_streams = xdp_session_get_streams (self->session);
+  if (session_streams == NULL || g_variant_n_children (session_streams) == 0)
+    {
+      fail_reconnection (self, task,
+                         g_error_new_literal (G_IO_ERROR, G_IO_ERROR_FAILED,
+                                              "The session has no streams"));
+      return;
+    }
+
+  g_free (self->restore_token);
+  self->restore_token = xdp_session_get_restore_token (self->session);
+
+  stream = g_variant_get_child_value (session_streams, 0);
+  g_variant_get (stream, "(ua{sv})", &self->node_id, NULL);
+  node_id_str = g_strdup_printf ("%u", self->node_id);
+  fd = xdp_session_open_pipewire_remote (self->session);
+
+  // Only the source is reopened, on the new PipeWire remote
+  gst_element_set_state (self->source, GST_STATE_NULL);
+  g_object_set (self->source,
+                "fd", fd,
+                "path", node_id_str,
+                NULL);
+
+  self->closed_handler_id = g_signal_connect (self->session,
+                                              "closed",
+                                              G_CALLBACK (on_session_closed),
+                                              self);
+
+  self->ended = FALSE;
+  update_state (self);
+
+  g_signal_emit (self,
+                 obj_signals[SIGNAL_RECONNECTED],
+                 0);
+
+  g_task_return_boolean (task, TRUE);
+}
+
+static void
+on_reconnect_session_created (GObject      *source_object,
+                              GAsyncResult *res,
+                              gpointer      user_data)
+{
+  g_autoptr (GTask) task = G_TASK (user_data);
+  KasasaStream *self = g_task_get_source_object (task);
+  GError *error = NULL;
+
+  self->session = xdp_portal_create_screencast_session_finish (XDP_PORTAL (source_object),
+                                                               res,
+                                                               &error);
+  if (self->session == NULL)
+    {
+      fail_reconnection (self, task, error);
+      return;
+    }
+
+  xdp_session_start (self->session,
+                     g_task_get_task_data (task),
+                     NULL,
+                     on_reconnect_session_started,
+                     g_object_ref (task));
+}
+
+/*
+ * Start a new session restored from the previous one, and feed the kept
+ * pipeline with it; no dialog is shown if the portal accepts the token.
+ * If the reconnection fails, "eos" is emitted again and the stream can't be
+ * reconnected anymore. The stream takes ownership of @parent
+ */
+void
+kasasa_stream_reconnect_async (KasasaStream        *self,
+                               XdpPortal           *portal,
+                               XdpParent           *parent,
+                               GAsyncReadyCallback  callback,
+                               gpointer             user_data)
+{
+  g_autoptr (GTask) task = NULL;
+
+  g_return_if_fail (KASASA_IS_STREAM (self));
+  g_return_if_fail (XDP_IS_PORTAL (portal));
+
+  task = g_task_new (self, NULL, callback, user_data);
+  g_task_set_source_tag (task, kasasa_stream_reconnect_async);
+  // Owned by the task, so it's valid until the session dialog is done
+  g_task_set_task_data (task, parent, (GDestroyNotify) xdp_parent_free);
+
+  // Reconnected by another screencast of the stream meanwhile
+  if (!self->ended)
+    {
+      g_task_return_boolean (task, TRUE);
+      return;
+    }
+
+  if (self->restore_token == NULL || self->session != NULL)
+    {
+      g_task_return_new_error (task, G_IO_ERROR,
+                               self->session ? G_IO_ERROR_PENDING : G_IO_ERROR_NOT_SUPPORTED,
+                               self->session ? "Already reconnecting" : "No session to restore");
+      return;
+    }
+
+  xdp_portal_create_screencast_session (portal,
+                                        XDP_OUTPUT_WINDOW | XDP_OUTPUT_MONITOR,
+                                        XDP_SCREENCAST_FLAG_NONE,
+                                        XDP_CURSOR_MODE_HIDDEN,
+                                        XDP_PERSIST_MODE_TRANSIENT,
+                                        self->restore_token,
+                                        NULL,
+                                        on_reconnect_session_created,
+                                        g_steal_pointer (&task));
+}
+
+gboolean
+kasasa_stream_reconnect_finish (KasasaStream  *self,
+                                GAsyncResult  *result,
+                                GError       **error)
+{
+  g_return_val_if_fail (KASASA_IS_STREAM (self), FALSE);
+  g_return_val_if_fail (g_task_is_valid (result, self), FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+// The last sample is held while at least one branch needs it
+void
+kasasa_stream_keep_last_sample (KasasaStream *self,
+                                gboolean      keep)
+{
+  g_return_if_fail (KASASA_IS_STREAM (self));
+
+  if (keep)
+    self->n_keeping_last_sample++;
+  else if (self->n_keeping_last_sample > 0)
+    self->n_keeping_last_sample--;
+
+  g_object_set (self->fakesink,
+                "enable-last-sample", self->n_keeping_last_sample > 0,
+                NULL);
+}
+
+// Returns the latest original frame (BGRx), or NULL
+GstSample *
+kasasa_stream_get_last_sample (KasasaStream *self)
+{
+  GstSample *sample = NULL;
+
+  g_return_val_if_fail (KASASA_IS_STREAM (self), NULL);
+
+  g_object_get (self->fakesink,
+                "last-sample", &sample,
+                NULL);
+
+  return sample;
+}
+
+static void
+kasasa_stream_dispose (GObject *object)
+{
+  KasasaStream *self = KASASA_STREAM (object);
+
+  if (self->pipeline)
+    {
+      GstBus *bus = gst_element_get_bus (self->pipeline);
+
+      gst_bus_remove_signal_watch (bus);
+      g_signal_handlers_disconnect_by_data (bus, self);
+      gst_object_unref (bus);
+
+      gst_element_set_state (self->pipeline, GST_STATE_NULL);
+      gst_object_unref (self->pipeline);
+      self->pipeline = NULL;
+    }
+
+  if (self->session)
+    {
+      g_clear_signal_handler (&self->closed_handler_id, self->session);
+      xdp_session_close (self->session);
+
+      g_clear_object (&self->session);
+    }
+
+  g_clear_pointer (&self->restore_token, g_free);
+
+  G_OBJECT_CLASS (kasasa_stream_parent_class)->dispose (object);
+}
+
+static void
+kasasa_stream_class_init (KasasaStreamClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  // Signals
+  obj_signals[SIGNAL_EOS] =
+    g_signal_new ("eos",
+                  KASASA_TYPE_STREAM,
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL, NULL,
+                  NULL,
+                  G_TYPE_NONE,            // no return value
+                  0);                     // no argument
+
+  obj_signals[SIGNAL_ERROR] =
+    g_signal_new ("error",
+                  KASASA_TYPE_STREAM,
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL, NULL,
+                  NULL,
+                  G_TYPE_NONE,            // no return value
+                  1,                      // 1 argument
+                  G_TYPE_STRING);         // error message
+
+  obj_signals[SIGNAL_RECONNECTED] =
+    g_signal_new ("reconnected",
+                  KASASA_TYPE_STREAM,
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL, NULL,
+                  NULL,
+                  G_TYPE_NONE,            // no return value
+                  0);                     // no argument
+
+  object_class->dispose = kasasa_stream_dispose;
+}
+
+static void
+kasasa_stream_init (KasasaStream *self)
+{
+}
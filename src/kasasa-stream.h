@@ -0,0 +1,55 @@
+/* kasasa-stream.h
+ *
+ * Copyright 2026 Kelvin Novais
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gst/gst.h>
+#include <libportal/portal.h>
+
+G_BEGIN_DECLS
+
+#define KASASA_TYPE_STREAM (kasasa_stream_get_type ())
+
+G_DECLARE_FINAL_TYPE (KasasaStream, kasasa_stream, KASASA, STREAM, GObject)
+
+KasasaStream *kasasa_stream_new (XdpSession *session,
+                                 gint        fd,
+                                 guint       node_id);
+guint kasasa_stream_get_node_id (KasasaStream *stream);
+gboolean kasasa_stream_add_branch (KasasaStream *stream,
+                                   GstElement   *branch);
+void kasasa_stream_remove_branch (KasasaStream *stream,
+                                  GstElement   *branch);
+void kasasa_stream_play (KasasaStream *stream);
+void kasasa_stream_pause (KasasaStream *stream);
+void kasasa_stream_keep_last_sample (KasasaStream *stream,
+                                     gboolean      keep);
+GstSample *kasasa_stream_get_last_sample (KasasaStream *stream);
+gboolean kasasa_stream_can_reconnect (KasasaStream *stream);
+void kasasa_stream_reconnect_async (KasasaStream        *stream,
+                                    XdpPortal           *portal,
+                                    XdpParent           *parent,
+                                    GAsyncReadyCallback  callback,
+                                    gpointer             user_data);
+gboolean kasasa_stream_reconnect_finish (KasasaStream  *stream,
+                                         GAsyncResult  *result,
+                                         GError       **error);
+
+G_END_DECLS
@@ -0,0 +1,246 @@
+/* kasasa-texture-region.c
+ *
+ * Copyright 2026 Kelvin Novais
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <string.h>
+
+#include "kasasa-texture-region.h"
+
+/*
+ * KasasaTextureRegion is a GdkPaintable showing a rectangle of a texture. The
+ * texture isn't copied: many regions can share the same texture, which is
+ * decoded (and uploaded to the GPU) only once.
+ */
+
+struct _KasasaTextureRegion
+{
+  GObject                  parent_instance;
+
+  /* Instance variables */
+  GdkTexture              *texture;
+  // In texture pixels
+  graphene_rect_t          region;
+};
+
+static void kasasa_texture_region_paintable_init (GdkPaintableInterface *iface);
+
+G_DEFINE_FINAL_TYPE_WITH_CODE (KasasaTextureRegion, kasasa_texture_region, G_TYPE_OBJECT,
+                               G_IMPLEMENT_INTERFACE (GDK_TYPE_PAINTABLE,
+                                                      kasasa_texture_region_paintable_init))
+
+static void
+kasasa_texture_region_snapshot (GdkPaintable *paintable,
+                                GdkSnapshot  *snapshot,
+                                gdouble       width,
+                                gdouble       height)
+{
+  KasasaTextureRegion *self = KASASA_TEXTURE_REGION (paintable);
+  gdouble scale_x = width / self->region.size.width;
+  gdouble scale_y = height / self->region.size.height;
+
+  // Draw the whole texture, moved and scaled so the region fills the bounds,
+  // and clip everything else
+  gtk_snapshot_push_clip (GTK_SNAPSHOT (snapshot),
+                          &GRAPHENE_RECT_INIT (0, 0, width, height));
+  gtk_snapshot_append_texture (GTK_SNAPSHOT (snapshot),
+                               self->texture,
+                               &GRAPHENE_RECT_INIT (-self->region.origin.x * scale_x,
+                                                    -self->region.origin.y * scale_y,
+                                                    gdk_texture_get_width (self->texture) * scale_x,
+                                                    gdk_texture_get_height (self->texture) * scale_y));
+  gtk_snapshot_pop (GTK_SNAPSHOT (snapshot));
+}
+
+static gint
+kasasa_texture_region_get_intrinsic_width (GdkPaintable *paintable)
+{
+  return (gint) KASASA_TEXTURE_REGION (paintable)->region.size.width;
+}
+
+static gint
+kasasa_texture_region_get_intrinsic_height (GdkPaintable *paintable)
+{
+  return (gint) KASASA_TEXTURE_REGION (paintable)->region.size.height;
+}
+
+static GdkPaintableFlags
+kasasa_texture_region_get_flags (GdkPaintable *paintable)
+{
+  return GDK_PAINTABLE_STATIC_CONTENTS | GDK_PAINTABLE_STATIC_SIZE;
+}
+
+GdkTexture *
+kasasa_texture_region_get_texture (KasasaTextureRegion *self)
+{
+  g_return_val_if_fail (KASASA_IS_TEXTURE_REGION (self), NULL);
+
+  return self->texture;
+}
+
+void
+kasasa_texture_region_get_region (KasasaTextureRegion *self,
+                                  graphene_rect_t     *region)
+{
+  g_return_if_fail (KASASA_IS_TEXTURE_REGION (self));
+
+  *region = self->region;
+}
+
+/*
+ * Returns a new texture with only the pixels of the region (e.g. for the
+ * clipboard). The whole shared texture is downloaded, and the rows of the
+ * region are copied out of it, so that the download isn't kept alive
+ */
+GdkTexture *
+kasasa_texture_region_to_texture (KasasaTextureRegion *self)
+{
+  g_autoptr (GdkTextureDownloader) downloader = NULL;
+  g_autoptr (GBytes) bytes = NULL;
+  const guchar *data = NULL;
+  guchar *region_data = NULL;
+  gsize stride, row_size;
+  gint x, y, width, height;
+
+  g_return_val_if_fail (KASASA_IS_TEXTURE_REGION (self), NULL);
+
+  x = (gint) self->region.origin.x;
+  y = (gint) self->region.origin.y;
+  width = (gint) self->region.size.width;
+  height = (gint) self->region.size.height;
+
+  // 4 bytes per pixel
+  downloader = gdk_texture_downloader_new (self->texture);
+  gdk_texture_downloader_set_format (downloader, GDK_MEMORY_DEFAULT);
+  bytes = gdk_texture_downloader_download_bytes (downloader, &stride);
+
+  data = g_bytes_get_data (bytes, NULL);
+  row_size = (gsize) width * 4;
+  region_data = g_malloc (row_size * height);
+  for (gint row = 0; row < height; row++)
+    memcpy (region_data + row * row_size,
+            data + (gsize) (y + row) * stride + (gsize) x * 4,
+            row_size);
+
+  return gdk_memory_texture_new (width, height, GDK_MEMORY_DEFAULT,
+                                 g_bytes_new_take (region_data, row_size * height),
+                                 row_size);
+}
+
+// Screenshots showing a region of a texture, kept on the texture itself
+static GQuark
+get_n_shown_quark (void)
+{
+  return g_quark_from_static_string ("kasasa-texture-region-n-shown");
+}
+
+// Tell whether a screenshot shows the region, for the memory accounting
+void
+kasasa_texture_region_set_shown (KasasaTextureRegion *self,
+                                 gboolean             shown)
+{
+  guint n_shown;
+
+  g_return_if_fail (KASASA_IS_TEXTURE_REGION (self));
+
+  n_shown = GPOINTER_TO_UINT (g_object_get_qdata (G_OBJECT (self->texture),
+                                                  get_n_shown_quark ()));
+  if (shown)
+    n_shown++;
+  else if (n_shown > 0)
+    n_shown--;
+
+  g_object_set_qdata (G_OBJECT (self->texture), get_n_shown_quark (),
+                      GUINT_TO_POINTER (n_shown));
+}
+
+/*
+ * The shared texture is split between the regions shown, so that the sum of
+ * their usages accounts it once
+ */
+gsize
+kasasa_texture_region_get_memory_usage (KasasaTextureRegion *self)
+{
+  guint n_shown;
+
+  g_return_val_if_fail (KASASA_IS_TEXTURE_REGION (self), 0);
+
+  n_shown = GPOINTER_TO_UINT (g_object_get_qdata (G_OBJECT (self->texture),
+                                                  get_n_shown_quark ()));
+
+  // 4 bytes per pixel
+  return (gsize) gdk_texture_get_width (self->texture)
+         * gdk_texture_get_height (self->texture) * 4 / MAX (n_shown, 1);
+}
+
+static void
+kasasa_texture_region_paintable_init (GdkPaintableInterface *iface)
+{
+  iface->snapshot = kasasa_texture_region_snapshot;
+  iface->get_intrinsic_width = kasasa_texture_region_get_intrinsic_width;
+  iface->get_intrinsic_height = kasasa_texture_region_get_intrinsic_height;
+  iface->get_flags = kasasa_texture_region_get_flags;
+}
+
+static void
+kasasa_texture_region_dispose (GObject *object)
+{
+  KasasaTextureRegion *self = KASASA_TEXTURE_REGION (object);
+
+  g_clear_object (&self->texture);
+
+  G_OBJECT_CLASS (kasasa_texture_region_parent_class)->dispose (object);
+}
+
+static void
+kasasa_texture_region_class_init (KasasaTextureRegionClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->dispose = kasasa_texture_region_dispose;
+}
+
+static void
+kasasa_texture_region_init (KasasaTextureRegion *self)
+{
+}
+
+// The region is clamped to the texture and rounded to whole pixels
+KasasaTextureRegion *
+kasasa_texture_region_new (GdkTexture            *texture,
+                           const graphene_rect_t *region)
+{
+  KasasaTextureRegion *self = NULL;
+  graphene_rect_t bounds;
+
+  g_return_val_if_fail (GDK_IS_TEXTURE (texture), NULL);
+  g_return_val_if_fail (region != NULL, NULL);
+
+  self = g_object_new (KASASA_TYPE_TEXTURE_REGION, NULL);
+  self->texture = g_object_ref (texture);
+
+  graphene_rect_init (&bounds, 0, 0,
+                      gdk_texture_get_width (texture),
+                      gdk_texture_get_height (texture));
+  graphene_rect_round_extents (region, &self->region);
+  if (!graphene_rect_intersection (&self->region, &bounds, &self->region)
+      || self->region.size.width < 1 || self->region.size.height < 1)
+    graphene_rect_init (&self->region, 0, 0, 1, 1);
+
+  return self;
+}
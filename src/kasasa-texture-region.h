@@ -0,0 +1,41 @@
+/* kasasa-texture-region.h
+ *
+ * Copyright 2026 Kelvin Novais
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+#define KASASA_TYPE_TEXTURE_REGION (kasasa_texture_region_get_type ())
+
+G_DECLARE_FINAL_TYPE (KasasaTextureRegion, kasasa_texture_region, KASASA, TEXTURE_REGION, GObject)
+
+KasasaTextureRegion *kasasa_texture_region_new (GdkTexture            *texture,
+                                                const graphene_rect_t *region);
+GdkTexture *kasasa_texture_region_get_texture (KasasaTextureRegion *texture_region);
+void kasasa_texture_region_get_region (KasasaTextureRegion *texture_region,
+                                       graphene_rect_t     *region);
+GdkTexture *kasasa_texture_region_to_texture (KasasaTextureRegion *texture_region);
+void kasasa_texture_region_set_shown (KasasaTextureRegion *texture_region,
+                                      gboolean             shown);
+gsize kasasa_texture_region_get_memory_usage (KasasaTextureRegion *texture_region);
+
+G_END_DECLS
@@ -23,11 +23,34 @@
 #include <glib/gi18n.h>
 
 #include "kasasa-content-container.h"
+#include "kasasa-settings.h"
 #include "kasasa-window.h"
 
 // Defined on GSchema and preferences
 #define MIN_OCCUPY_SCREEN 0.1
 
+// Cached information about the monitors, used to compute the window size
+typedef struct
+{
+  GdkMonitor *monitor;              // monitor where the window is
+  GdkRectangle geometry;            // geometry of 'monitor'
+  gdouble scale;                    // scale of the window surface
+  gdouble max_scale;                // max scale among all monitors
+  gboolean different_scales;        // monitors have different scales
+} DisplayModel;
+
+// Purposes of the (one shot) window timers
+typedef enum
+{
+  WINDOW_TIMER_HIDE_TOOLBAR,
+  WINDOW_TIMER_HIDE_HEADER_BAR,
+  WINDOW_TIMER_REVEAL_HEADER_BAR,
+  WINDOW_TIMER_MINIATURIZE,
+  WINDOW_TIMER_END_MINIATURE_FLASH,
+
+  WINDOW_TIMER_N_ELEMENTS
+} WindowTimer;
+
 struct _KasasaWindow
 {
   AdwApplicationWindow parent_instance;
@@ -42,28 +65,148 @@ struct _KasasaWindow
   GtkToggleButton *lock_button;
   GtkProgressBar *progress_bar;
   GtkStack *stack;
+  GtkPicture *miniature_picture;
 
   /* State variables */
-  gboolean hide_menu_requested;
   gboolean mouse_over_window;
   gboolean hiding_window;
   gboolean block_miniaturization;
-  gboolean window_is_miniaturized;
+  MiniaturizationState miniaturization_state;
+  gboolean first_resize;
 
   /* Instance variables */
-  GSettings *settings;
+  KasasaSettings *settings;
+  const KasasaSettingsValues *values;
+  gulong settings_handler_id;
   AdwAnimation *window_opacity_animation;
-  GCancellable *miniaturization_canceller;
+  GArray *opacity_callbacks;
+  AdwAnimation *resize_animation;
+  gdouble resize_from_width;
+  gdouble resize_from_height;
+  gdouble resize_to_width;
+  gdouble resize_to_height;
+  GSource *timers[WINDOW_TIMER_N_ELEMENTS];
+  gint64 auto_discard_start;
+  gint64 auto_discard_deadline;
+  guint auto_discard_source;
+  guint auto_discard_tick_id;
+
+  DisplayModel display_model;
+  GListModel *monitors;
+  GdkSurface *surface;
+  gulong monitors_changed_handler_id;
+  gulong enter_monitor_handler_id;
+  gulong scale_handler_id;
 };
 
 typedef struct
 {
   HideWindowCallback function;
+  HideWindowCallback cancelled;
   gpointer data;
 } HideWindowCallbackInfo;
 
 G_DEFINE_FINAL_TYPE (KasasaWindow, kasasa_window, ADW_TYPE_APPLICATION_WINDOW)
 
+/*
+ * Window timers
+ *
+ * Each purpose has at most one source, which is created on the first request
+ * and then only rescheduled (by changing its ready time), so bursts of pointer
+ * events don't queue several callbacks. The sources are destroyed on dispose
+ */
+static gboolean
+timer_source_dispatch (GSource     *source,
+                       GSourceFunc  callback,
+                       gpointer     user_data)
+{
+  // Disarm the source until it's scheduled again
+  g_source_set_ready_time (source, -1);
+
+  if (callback != NULL)
+    ((GSourceOnceFunc) callback) (user_data);
+
+  return G_SOURCE_CONTINUE;
+}
+
+static GSourceFuncs timer_source_funcs =
+{
+  .dispatch = timer_source_dispatch,
+};
+
+static void
+schedule_timer (KasasaWindow    *self,
+                WindowTimer      timer,
+                guint            interval,
+                GSourceOnceFunc  function)
+{
+  GSource *source = self->timers[timer];
+
+  if (source == NULL)
+    {
+      source = g_source_new (&timer_source_funcs, sizeof (GSource));
+      g_source_set_callback (source, (GSourceFunc) function, self, NULL);
+      g_source_set_static_name (source, "[kasasa] window timer");
+      g_source_attach (source, NULL);
+      self->timers[timer] = source;
+    }
+
+  // 'interval' is in milliseconds
+  g_source_set_ready_time (source,
+                           g_get_monotonic_time () + (gint64) interval * 1000);
+}
+
+static void
+cancel_timer (KasasaWindow *self,
+              WindowTimer   timer)
+{
+  if (self->timers[timer] != NULL)
+    g_source_set_ready_time (self->timers[timer], -1);
+}
+
+static gboolean
+timer_pending (KasasaWindow *self,
+               WindowTimer   timer)
+{
+  return self->timers[timer] != NULL
+         && g_source_get_ready_time (self->timers[timer]) != -1;
+}
+
+static void
+destroy_timers (KasasaWindow *self)
+{
+  for (guint i = 0; i < WINDOW_TIMER_N_ELEMENTS; i++)
+    {
+      if (self->timers[i] == NULL)
+        continue;
+
+      g_source_destroy (self->timers[i]);
+      g_clear_pointer (&self->timers[i], g_source_unref);
+    }
+}
+
+static void
+end_miniature_flash (gpointer user_data)
+{
+  KasasaWindow *self = KASASA_WINDOW (user_data);
+
+  gtk_widget_remove_css_class (GTK_WIDGET (self), "miniature-flash");
+}
+
+// Highlight the miniature for a moment, e.g. when a watched content changes
+void
+kasasa_window_flash_miniature (KasasaWindow *self)
+{
+  g_return_if_fail (KASASA_IS_WINDOW (self));
+
+  if (!kasasa_window_is_miniaturized (self))
+    return;
+
+  gtk_widget_add_css_class (GTK_WIDGET (self), "miniature-flash");
+  schedule_timer (self, WINDOW_TIMER_END_MINIATURE_FLASH,
+                  WINDOW_MINIATURE_FLASH_DURATION, end_miniature_flash);
+}
+
 void
 kasasa_window_take_first_screenshot (KasasaWindow *self)
 {
@@ -99,154 +242,163 @@ kasasa_window_is_miniaturized (KasasaWindow *self)
 {
   g_return_val_if_fail (KASASA_IS_WINDOW (self), FALSE);
 
-  return self->window_is_miniaturized;
+  return self->miniaturization_state == MINIATURIZATION_STATE_MINIATURIZED;
 };
 
-static gboolean
-has_different_scalings (gdouble *max_scale)
+MiniaturizationState
+kasasa_window_get_miniaturization_state (KasasaWindow *self)
 {
-  GdkDisplay *display = NULL;
-  GListModel *monitors = NULL;
-  GObject *monitor = NULL;
-  gdouble min_s, max_s, current_scale;
-  guint n_items;
+  g_return_val_if_fail (KASASA_IS_WINDOW (self), MINIATURIZATION_STATE_NONE);
 
-  display = gdk_display_get_default ();
-  if (display == NULL)
-    {
-      g_warning ("Can't check for different scalings");
-      return FALSE;
-    }
+  if (timer_pending (self, WINDOW_TIMER_MINIATURIZE))
+    return MINIATURIZATION_STATE_PENDING;
 
-  monitors = gdk_display_get_monitors (display);
-  n_items = g_list_model_get_n_items (monitors);
-  g_info ("Number of monitors: %d", n_items);
+  return self->miniaturization_state;
+}
 
-  if (n_items == 0)
-    {
-      g_info ("Detected only 1 monitor, there's no different scales");
-      return FALSE;
-    }
+// Returns TRUE if any of the window timers (hiding controls, miniaturization)
+// is scheduled
+gboolean
+kasasa_window_has_pending_timers (KasasaWindow *self)
+{
+  g_return_val_if_fail (KASASA_IS_WINDOW (self), FALSE);
 
-  monitor = g_list_model_get_object (monitors, 0);
-  min_s = max_s = gdk_monitor_get_scale (GDK_MONITOR (monitor));
-  g_object_unref (monitor);
+  for (guint i = 0; i < WINDOW_TIMER_N_ELEMENTS; i++)
+    if (timer_pending (self, i))
+      return TRUE;
 
-  for (guint i = 1; i < n_items; i++)
-    {
-      monitor = g_list_model_get_object (monitors, i);
-      current_scale = gdk_monitor_get_scale (GDK_MONITOR (monitor));
+  return FALSE;
+}
 
-      min_s = MIN (current_scale, min_s);
-      max_s = MAX (current_scale, max_s);
+static void
+display_model_update_scales (KasasaWindow *self)
+{
+  DisplayModel *model = &self->display_model;
+  gdouble min_s = 0, max_s = 0;
+  guint n_items;
 
-      g_object_unref (monitor);
-    }
+  n_items = g_list_model_get_n_items (self->monitors);
+  g_info ("Number of monitors: %d", n_items);
 
-  if (min_s != max_s)
+  for (guint i = 0; i < n_items; i++)
     {
-      g_info ("Monitors have different scales: %.2f and %.2f [min, max]",
-              min_s, max_s);
-      *max_scale = max_s;
-      return TRUE;
+      g_autoptr (GdkMonitor) monitor = g_list_model_get_item (self->monitors, i);
+      gdouble current_scale = gdk_monitor_get_scale (monitor);
+
+      min_s = (i == 0) ? current_scale : MIN (current_scale, min_s);
+      max_s = (i == 0) ? current_scale : MAX (current_scale, max_s);
     }
+
+  model->different_scales = (min_s != max_s);
+  model->max_scale = max_s;
+
+  if (model->different_scales)
+    g_info ("Monitors have different scales: %.2f and %.2f [min, max]",
+            min_s, max_s);
   else
-    {
-      g_info ("Monitors have same scales");
-      return FALSE;
-    }
+    g_info ("Monitors have same scales");
 }
 
-static gboolean
-scaling (GtkWidget *widget,
-         gdouble *scale)
+static void
+display_model_set_monitor (KasasaWindow *self,
+                           GdkMonitor   *monitor)
 {
-  GdkDisplay *display = NULL;
-  GtkNative *native = NULL;
-  GdkSurface *surface = NULL;
+  DisplayModel *model = &self->display_model;
 
-  g_return_val_if_fail (GTK_IS_WIDGET (widget), TRUE);
+  g_set_object (&model->monitor, monitor);
 
-  display = gdk_display_get_default ();
-  if (display == NULL)
-    {
-      g_warning ("Couldn't get GdkDisplay");
-      return TRUE;
-    }
+  if (monitor != NULL)
+    gdk_monitor_get_geometry (monitor, &model->geometry);
+}
 
-  native = gtk_widget_get_native (widget);
-  if (native == NULL)
-    {
-      g_warning ("Couldn't get GtkNative");
-      return TRUE;
-    }
+// Find the monitor where the window is; if it's not known yet (e.g. the window
+// isn't mapped), fall back to the first monitor
+static void
+display_model_update_monitor (KasasaWindow *self)
+{
+  GdkMonitor *monitor = NULL;
+  g_autoptr (GdkMonitor) first_monitor = NULL;
 
-  surface = gtk_native_get_surface (native);
-  if (surface == NULL)
+  monitor = gdk_display_get_monitor_at_surface (gdk_surface_get_display (self->surface),
+                                                self->surface);
+
+  if (monitor == NULL)
     {
-      g_warning ("Couldn't get GdkSurface");
-      return TRUE;
+      first_monitor = g_list_model_get_item (self->monitors, 0);
+      monitor = first_monitor;
     }
 
-  *scale = gdk_surface_get_scale (surface);
+  if (monitor == NULL)
+    g_warning ("Couldn't get GdkMonitor");
 
-  return FALSE;
+  display_model_set_monitor (self, monitor);
 }
 
-static gboolean
-monitor_size (GtkWidget *widget,
-              gdouble *monitor_width,
-              gdouble *monitor_height)
+static void
+display_model_update_scale (KasasaWindow *self)
 {
-  GdkDisplay *display = NULL;
-  GtkNative *native = NULL;
-  GdkSurface *surface = NULL;
-  GdkMonitor *monitor = NULL;
-  GdkRectangle monitor_geometry;
-  gdouble hidpi_scale;
+  self->display_model.scale = gdk_surface_get_scale (self->surface);
+  g_info ("HiDPI scale: %.2f", self->display_model.scale);
+}
 
-  g_return_val_if_fail (GTK_IS_WIDGET (widget), TRUE);
+// The scale or the geometry of a monitor changed in place (e.g. from the
+// display settings)
+static void
+on_monitor_changed (GdkMonitor *monitor,
+                    GParamSpec *pspec,
+                    gpointer    user_data)
+{
+  KasasaWindow *self = KASASA_WINDOW (user_data);
 
-  if (scaling (widget, &hidpi_scale))
-    {
-      g_warning ("Couldn't get scaling");
-      return TRUE;
-    }
+  display_model_update_scales (self);
 
-  display = gdk_display_get_default ();
-  if (display == NULL)
-    {
-      g_warning ("Couldn't get GdkDisplay");
-      return TRUE;
-    }
+  if (monitor == self->display_model.monitor)
+    gdk_monitor_get_geometry (monitor, &self->display_model.geometry);
+}
 
-  native = gtk_widget_get_native (widget);
-  if (native == NULL)
-    {
-      g_warning ("Couldn't get GtkNative");
-      return TRUE;
-    }
+static void
+watch_monitor (KasasaWindow *self,
+               GdkMonitor   *monitor)
+{
+  g_signal_connect_object (monitor, "notify::scale",
+                           G_CALLBACK (on_monitor_changed), self, 0);
+  g_signal_connect_object (monitor, "notify::geometry",
+                           G_CALLBACK (on_monitor_changed), self, 0);
+}
 
-  surface = gtk_native_get_surface (native);
-  if (surface == NULL)
-    {
-      g_warning ("Couldn't get GdkSurface");
-      return TRUE;
-    }
+static void
+on_monitors_changed (GListModel *monitors,
+                     guint       position,
+                     guint       removed,
+                     guint       added,
+                     gpointer    user_data)
+{
+  KasasaWindow *self = KASASA_WINDOW (user_data);
 
-  monitor = gdk_display_get_monitor_at_surface (display, surface);
-  if (monitor == NULL)
+  for (guint i = position; i < position + added; i++)
     {
-      g_warning ("Couldn't get GdkMonitor");
-      return TRUE;
+      g_autoptr (GdkMonitor) monitor = g_list_model_get_item (monitors, i);
+      watch_monitor (self, monitor);
     }
 
-  gdk_monitor_get_geometry (monitor, &monitor_geometry);
+  display_model_update_scales (self);
+  display_model_update_monitor (self);
+}
 
-  *monitor_width = monitor_geometry.width * hidpi_scale;
-  *monitor_height = monitor_geometry.height * hidpi_scale;
+static void
+on_surface_enter_monitor (GdkSurface *surface,
+                          GdkMonitor *monitor,
+                          gpointer    user_data)
+{
+  display_model_set_monitor (KASASA_WINDOW (user_data), monitor);
+}
 
-  return FALSE;
+static void
+on_surface_scale_changed (GObject    *object,
+                          GParamSpec *pspec,
+                          gpointer    user_data)
+{
+  display_model_update_scale (KASASA_WINDOW (user_data));
 }
 
 // Compute the window size
@@ -260,14 +412,12 @@ compute_size (KasasaWindow *self,
               const gint content_height,
               const gint content_width)
 {
-  g_autoptr (GError) error = NULL;
+  const DisplayModel *model = &self->display_model;
   // gints
   gint image_width, image_height, image_area, max_width, max_height;
   // gdoubles
   gdouble monitor_width, monitor_height, monitor_area, header_bar_height,
-      occupy_area_factor, size_scale, target_scale, hidpi_scale, max_scale;
-
-  g_autoptr (GSettings) settings = g_settings_new ("io.github.kelvinnovais.Kasasa");
+      occupy_area_factor, size_scale, target_scale, hidpi_scale;
 
   if (!(content_height > 0 && content_width))
     {
@@ -275,25 +425,23 @@ compute_size (KasasaWindow *self,
       return TRUE;
     }
 
-  if (monitor_size (GTK_WIDGET (self), &monitor_width, &monitor_height))
+  if (model->monitor == NULL || model->scale <= 0)
     {
       g_warning ("Couldn't get monitor size");
       return TRUE;
     }
 
-  if (scaling (GTK_WIDGET (self), &hidpi_scale))
-    {
-      g_warning ("Couldn't get HiDPI scale");
-      return TRUE;
-    }
+  hidpi_scale = model->scale;
+  monitor_width = model->geometry.width * hidpi_scale;
+  monitor_height = model->geometry.height * hidpi_scale;
 
   // If the user has different scales for the monitors and the current scale is
   // less than the max scale, divide the image dimentions by the max scale. This
   // is needed because the screenshot size follows the max scale
-  if (has_different_scalings (&max_scale))
+  if (model->different_scales)
     {
-      image_width = content_width / max_scale;
-      image_height = content_height / max_scale;
+      image_width = content_width / model->max_scale;
+      image_height = content_height / model->max_scale;
     }
   else
     {
@@ -305,10 +453,10 @@ compute_size (KasasaWindow *self,
   monitor_area = monitor_width * monitor_height;
   image_area = image_height * image_width;
 
-  occupy_area_factor = g_settings_get_int (settings, "occupy-screen") / 100.0;
+  occupy_area_factor = self->values->occupy_screen / 100.0;
 
   header_bar_height =
-      g_settings_get_boolean (settings, "auto-hide-menu") ? 0 : 47;
+      self->values->auto_hide_menu ? 0 : 47;
 
   // factor for width and height that will achieve the desired area
   // occupation derived from:
@@ -359,7 +507,7 @@ compute_size (KasasaWindow *self,
   *nat_height = MAX (WINDOW_MIN_HEIGHT, *nat_height);
 
   // If the header bar is NOT hiding, then the window height must have more 47 px
-  if (!g_settings_get_boolean (settings, "auto-hide-menu"))
+  if (!self->values->auto_hide_menu)
     *nat_height += header_bar_height;
 
   g_info ("Physical monitor dimensions: %.2f x %.2f",
@@ -371,69 +519,95 @@ compute_size (KasasaWindow *self,
   return FALSE;
 }
 
-// Resize the window with an animation
+// Both dimensions are driven by a single animation, going from 0 to 1
+static void
+resize_window_cb (gdouble value,
+                  KasasaWindow *self)
+{
+  gdouble width = self->resize_from_width
+                  + (self->resize_to_width - self->resize_from_width) * value;
+  gdouble height = self->resize_from_height
+                   + (self->resize_to_height - self->resize_from_height) * value;
+
+  gtk_window_set_default_size (GTK_WINDOW (self),
+                               (gint) round (width),
+                               (gint) round (height));
+}
+
+static void
+on_resize_animation_done (AdwAnimation *animation,
+                          gpointer user_data)
+{
+  KasasaWindow *self = KASASA_WINDOW (user_data);
+
+  // Enable carousel again
+  kasasa_content_container_carousel_set_interactive (self->content_container,
+                                                     TRUE);
+}
+
+/*
+ * Resize the window with an animation
+ *
+ * There's a single resize animation per window: a request made while the
+ * window is still being resized retargets the running animation, starting from
+ * the current size and keeping the current speed
+ */
 void
 kasasa_window_resize_window (KasasaWindow *self,
                              gdouble new_height,
                              gdouble new_width)
 {
-  AdwAnimationTarget *target_h = NULL;
-  AdwAnimationTarget *target_w = NULL;
-  g_autoptr (AdwAnimation) animation_height = NULL;
-  g_autoptr (AdwAnimation) animation_width = NULL;
   gint default_width, default_height;
-  static gboolean first_run = TRUE;
+  gdouble velocity = 0;
+
+  g_return_if_fail (KASASA_IS_WINDOW (self));
+
+  // Merge requests for the size that the window is already going to
+  if (adw_animation_get_state (self->resize_animation) == ADW_ANIMATION_PLAYING
+      && self->resize_to_width == new_width
+      && self->resize_to_height == new_height)
+    return;
 
   gtk_window_get_default_size (GTK_WINDOW (self),
                                &default_width, &default_height);
 
+  // Convert the current speed (in pixels) to the new animation progress
+  if (adw_animation_get_state (self->resize_animation) == ADW_ANIMATION_PLAYING)
+    {
+      gdouble old_velocity =
+        adw_spring_animation_get_velocity (ADW_SPRING_ANIMATION (self->resize_animation));
+      gdouble delta_width = new_width - default_width;
+      gdouble delta_height = new_height - default_height;
+
+      if (fabs (delta_width) >= fabs (delta_height) && delta_width != 0)
+        velocity = old_velocity * (self->resize_to_width - self->resize_from_width) / delta_width;
+      else if (delta_height != 0)
+        velocity = old_velocity * (self->resize_to_height - self->resize_from_height) / delta_height;
+
+      velocity = MAX (0, velocity);
+    }
+
+  self->resize_from_width = default_width;
+  self->resize_from_height = default_height;
+  self->resize_to_width = new_width;
+  self->resize_to_height = new_height;
+
   // Disable the carousel navigation while the window is being resized
   kasasa_content_container_carousel_set_interactive (self->content_container,
                                                      FALSE);
 
-  // Set targets
-  target_h =
-      adw_property_animation_target_new (G_OBJECT (self), "default-height");
-  target_w =
-      adw_property_animation_target_new (G_OBJECT (self), "default-width");
-
-  // Animation for resizing height
-  animation_height = adw_timed_animation_new (
-      GTK_WIDGET (self),        // widget
-      (gdouble) default_height, // from
-      new_height,               // to
-      WINDOW_RESIZING_DURATION, // duration
-      target_h                  // target
-  );
-  adw_timed_animation_set_easing (ADW_TIMED_ANIMATION (animation_height),
-                                  ADW_EASE_OUT_EXPO);
-
-  // Animation for resizing width
-  animation_width = adw_timed_animation_new (
-      GTK_WIDGET (self),        // widget
-      (gdouble) default_width,  // from
-      new_width,                // to
-      WINDOW_RESIZING_DURATION, // duration
-      target_w                  // target
-  );
-  adw_timed_animation_set_easing (ADW_TIMED_ANIMATION (animation_width),
-                                  ADW_EASE_OUT_EXPO);
-
-  if (first_run)
+  adw_spring_animation_set_initial_velocity (ADW_SPRING_ANIMATION (self->resize_animation),
+                                             velocity);
+
+  if (self->first_resize)
     {
-      adw_animation_skip (animation_width);
-      adw_animation_skip (animation_height);
-      first_run = FALSE;
+      self->first_resize = FALSE;
+      adw_animation_skip (self->resize_animation);
     }
   else
     {
-      adw_animation_play (animation_width);
-      adw_animation_play (animation_height);
+      adw_animation_play (self->resize_animation);
     }
-
-  // Enable carousel again
-  kasasa_content_container_carousel_set_interactive (self->content_container,
-                                                     TRUE);
 }
 
 void
@@ -460,60 +634,92 @@ change_opacity_cb (double value,
   gtk_widget_set_opacity (GTK_WIDGET (self), value);
 }
 
-void
-kasasa_window_change_opacity (KasasaWindow *self,
-                              Opacity opacity_direction)
+static void
+on_opacity_animation_done (AdwAnimation *animation,
+                           gpointer user_data)
 {
-  AdwAnimationTarget *target = NULL;
-  gdouble opacity = g_settings_get_double (self->settings, "opacity");
-
-  // Set from and to target values, according to the mode (increase or decrease opacity)
-  gdouble from = gtk_widget_get_opacity (GTK_WIDGET (self));
-  gdouble to = (opacity_direction == OPACITY_INCREASE) ? 1.00 : opacity;
+  KasasaWindow *self = KASASA_WINDOW (user_data);
+  g_autoptr (GArray) callbacks = NULL;
 
-  // Return if this option is disabled
-  if (!g_settings_get_boolean (self->settings, "change-opacity"))
+  if (self->opacity_callbacks == NULL || self->opacity_callbacks->len == 0)
     return;
 
-  // Return if the window is hiding/hidden when retaking the screenshot
-  // it prevents the opacity increase again if the mouse leave the window
-  if (self->hiding_window)
-    return;
+  // A callback can request a new animation (and queue a new callback), so run
+  // the current ones from their own array
+  callbacks = g_steal_pointer (&self->opacity_callbacks);
+  self->opacity_callbacks = g_array_new (FALSE, FALSE, sizeof (HideWindowCallbackInfo));
 
-  // Return if the opacity is already 100%
-  if (opacity == OPACITY_INCREASE && gtk_widget_get_opacity (GTK_WIDGET (self)) == 1.00)
+  for (guint i = 0; i < callbacks->len; i++)
+    {
+      HideWindowCallbackInfo *cb = &g_array_index (callbacks, HideWindowCallbackInfo, i);
+      cb->function (cb->data);
+    }
+}
+
+// The animation won't reach the target the callbacks were queued for
+static void
+cancel_opacity_callbacks (KasasaWindow *self)
+{
+  g_autoptr (GArray) callbacks = NULL;
+
+  if (self->opacity_callbacks == NULL || self->opacity_callbacks->len == 0)
     return;
 
-  // Pause an animation
-  // The "if" verifies if the animation was called at least once
-  if (ADW_IS_ANIMATION (self->window_opacity_animation))
-    adw_animation_pause (self->window_opacity_animation);
+  callbacks = g_steal_pointer (&self->opacity_callbacks);
+  self->opacity_callbacks = g_array_new (FALSE, FALSE, sizeof (HideWindowCallbackInfo));
 
-  g_clear_object (&self->window_opacity_animation);
+  for (guint i = 0; i < callbacks->len; i++)
+    {
+      HideWindowCallbackInfo *cb = &g_array_index (callbacks, HideWindowCallbackInfo, i);
 
-  target =
-      adw_callback_animation_target_new ((AdwAnimationTargetFunc) change_opacity_cb,
-                                         self,
-                                         NULL);
+      if (cb->cancelled != NULL)
+        cb->cancelled (cb->data);
+    }
+}
+
+/*
+ * Animate the window opacity from its current value to 'to'
+ *
+ * The window has a single opacity animation, which is retargeted if it's
+ * already playing; its queued callbacks are kept, and called when the
+ * animation finishes
+ */
+static void
+animate_opacity (KasasaWindow *self,
+                 gdouble to,
+                 guint duration)
+{
+  AdwTimedAnimation *animation = ADW_TIMED_ANIMATION (self->window_opacity_animation);
 
-  self->window_opacity_animation = adw_timed_animation_new (
-      GTK_WIDGET (self), // widget
-      from, to,          // opacity from to
-      270,               // duration
-      target             // target
-  );
+  adw_timed_animation_set_value_from (animation,
+                                      gtk_widget_get_opacity (GTK_WIDGET (self)));
+  adw_timed_animation_set_value_to (animation, to);
+  adw_timed_animation_set_duration (animation, duration);
 
   adw_animation_play (self->window_opacity_animation);
 }
 
-static void
-on_window_hidden (AdwAnimation *animation,
-                  gpointer user_data)
+void
+kasasa_window_change_opacity (KasasaWindow *self,
+                              Opacity opacity_direction)
 {
-  HideWindowCallbackInfo *cb = user_data;
+  // Set the target value, according to the mode (increase or decrease opacity)
+  gdouble to = (opacity_direction == OPACITY_INCREASE) ? 1.00 : self->values->opacity;
+
+  // Return if this option is disabled
+  if (!self->values->change_opacity)
+    return;
+
+  // Return if the window is hiding/hidden when retaking the screenshot
+  // it prevents the opacity increase again if the mouse leave the window
+  if (self->hiding_window)
+    return;
+
+  // Return if the opacity is already 100%
+  if (opacity_direction == OPACITY_INCREASE && gtk_widget_get_opacity (GTK_WIDGET (self)) == 1.00)
+    return;
 
-  cb->function (cb->data);
-  g_free (cb);
+  animate_opacity (self, to, 270);
 }
 
 /*
@@ -524,100 +730,148 @@ on_window_hidden (AdwAnimation *animation,
  * This trick is required because by using gtk_widget_set_visible (window, FALSE),
  * cause the window to be unpinned.
  *
- * Optionally, this functon can receive a 'callback', that is called when hiding
- * window is finished. This argument can be NULL, as well 'callback_data'.
+ * Optionally, this functon can receive a 'callback', that is called once when
+ * the opacity animation is finished. If the animation is retargeted to the
+ * opposite direction (or the window is disposed) first, 'cancelled_callback'
+ * is called instead, so that the caller can restore its state. These arguments
+ * can be NULL, as well 'callback_data'.
  */
 void
 kasasa_window_hide_window (KasasaWindow *self,
                            gboolean hide,
                            HideWindowCallback callback,
+                           HideWindowCallback cancelled_callback,
                            gpointer callback_data)
 {
-  AdwAnimationTarget *target = NULL;
-  gdouble from, to;
-
   g_return_if_fail (KASASA_IS_WINDOW (self));
 
-  // Pause an animation
-  // The "if" verifies if the animation was called at least once
-  if (ADW_IS_ANIMATION (self->window_opacity_animation))
-    {
-      adw_animation_pause (self->window_opacity_animation);
-      g_object_unref (self->window_opacity_animation);
-    }
-
-  // Set 'from' and 'to' target values
-  from = gtk_widget_get_opacity (GTK_WIDGET (self));
-  to = (hide) ? 0.00 : 1.00;
+  // The queued callbacks expected the window to reach the opposite state
+  if (self->hiding_window != hide)
+    cancel_opacity_callbacks (self);
 
   // Set if the window is hiding or being revealed
   self->hiding_window = hide;
 
-  target =
-      adw_callback_animation_target_new ((AdwAnimationTargetFunc) change_opacity_cb,
-                                         self,
-                                         NULL);
-
-  self->window_opacity_animation = adw_timed_animation_new (
-      GTK_WIDGET (self),                     // widget
-      from, to,                              // opacity from to
-      (hide) ? WINDOW_HIDING_DURATION : 200, // duration
-      target                                 // target
-  );
-
+  // Queue the callback before playing: the animation finishes immediately if
+  // the window isn't mapped
   if (callback != NULL)
     {
-      HideWindowCallbackInfo *cb_info = g_new0 (HideWindowCallbackInfo, 1);
-      cb_info->function = callback;
-      cb_info->data = callback_data;
-      g_signal_connect (self->window_opacity_animation, "done",
-                        G_CALLBACK (on_window_hidden), cb_info);
+      HideWindowCallbackInfo cb_info = { callback, cancelled_callback, callback_data };
+      g_array_append_val (self->opacity_callbacks, cb_info);
     }
 
-  adw_animation_play (self->window_opacity_animation);
+  animate_opacity (self,
+                   (hide) ? 0.00 : 1.00,
+                   (hide) ? WINDOW_HIDING_DURATION : 200);
 }
 
 static gboolean
 auto_discard_window_cb (gpointer user_data)
 {
-  gdouble new_fraction = 0;
   KasasaWindow *self = KASASA_WINDOW (user_data);
 
-  if (!gtk_toggle_button_get_active (self->auto_discard_button))
-    {
-      gtk_progress_bar_set_fraction (self->progress_bar, 0.0);
-      return G_SOURCE_REMOVE;
-    }
+  // The source is removed when returning
+  self->auto_discard_source = 0;
+  gtk_window_close (GTK_WINDOW (self));
 
-  new_fraction = gtk_progress_bar_get_fraction (self->progress_bar) - 0.005;
+  return G_SOURCE_REMOVE;
+}
 
-  if (new_fraction <= 0)
-    {
-      gtk_window_close (GTK_WINDOW (self));
-      return G_SOURCE_REMOVE;
-    }
-  else
-    {
-      gtk_progress_bar_set_fraction (self->progress_bar, new_fraction);
-    }
+// Update the ProgressBar from the frame clock; this is only called while the
+// ProgressBar is mapped, so there are no wakeups while it's hidden
+static gboolean
+auto_discard_tick_cb (GtkWidget *widget,
+                      GdkFrameClock *frame_clock,
+                      gpointer user_data)
+{
+  KasasaWindow *self = KASASA_WINDOW (user_data);
+  gint64 now = gdk_frame_clock_get_frame_time (frame_clock);
+  gdouble total = self->auto_discard_deadline - self->auto_discard_start;
+  gdouble fraction = CLAMP ((self->auto_discard_deadline - now) / total, 0.0, 1.0);
+  gdouble previous = gtk_progress_bar_get_fraction (self->progress_bar);
+
+  // Only relayout the ProgressBar when the change is visible (~1 px)
+  if (fabs (previous - fraction) * gtk_widget_get_width (widget) >= 1.0)
+    gtk_progress_bar_set_fraction (self->progress_bar, fraction);
 
   return G_SOURCE_CONTINUE;
 }
 
+static void
+start_auto_discard_tick (KasasaWindow *self)
+{
+  if (self->auto_discard_tick_id > 0 || self->auto_discard_source == 0)
+    return;
+
+  self->auto_discard_tick_id =
+    gtk_widget_add_tick_callback (GTK_WIDGET (self->progress_bar),
+                                  auto_discard_tick_cb,
+                                  self,
+                                  NULL);
+}
+
+static void
+stop_auto_discard_tick (KasasaWindow *self)
+{
+  if (self->auto_discard_tick_id == 0)
+    return;
+
+  gtk_widget_remove_tick_callback (GTK_WIDGET (self->progress_bar),
+                                   self->auto_discard_tick_id);
+  self->auto_discard_tick_id = 0;
+}
+
+static void
+stop_auto_discard_window (KasasaWindow *self)
+{
+  g_clear_handle_id (&self->auto_discard_source, g_source_remove);
+  stop_auto_discard_tick (self);
+  gtk_progress_bar_set_fraction (self->progress_bar, 0.0);
+}
+
+/*
+ * Close the window when the auto discard time is reached
+ *
+ * A single timer closes the window at the deadline; the ProgressBar only
+ * displays the remaining time. Calling this function again restarts the timer
+ */
 void
 kasasa_window_auto_discard_window (KasasaWindow *self)
 {
   gdouble time_seconds;
-  guint time_miliseconds;
 
   g_return_if_fail (KASASA_IS_WINDOW (self));
 
-  time_seconds = 60 * g_settings_get_double (self->settings,
-                                             "auto-discard-window-time");
-  // We are goning to decrease the ProgressBar 0.005 (or 0.5%) each function call
-  time_miliseconds = (guint) ((time_seconds / 200) * 1000);
+  stop_auto_discard_window (self);
+
+  time_seconds = 60 * self->values->auto_discard_window_time;
+
+  self->auto_discard_start = g_get_monotonic_time ();
+  self->auto_discard_deadline =
+    self->auto_discard_start + (gint64) (time_seconds * G_USEC_PER_SEC);
+
+  self->auto_discard_source = g_timeout_add ((guint) (time_seconds * 1000),
+                                             auto_discard_window_cb,
+                                             self);
+
   gtk_progress_bar_set_fraction (self->progress_bar, 1.0);
-  g_timeout_add (time_miliseconds, auto_discard_window_cb, self);
+
+  if (gtk_widget_get_mapped (GTK_WIDGET (self->progress_bar)))
+    start_auto_discard_tick (self);
+}
+
+static void
+on_progress_bar_map (GtkWidget *widget,
+                     gpointer user_data)
+{
+  start_auto_discard_tick (KASASA_WINDOW (user_data));
+}
+
+static void
+on_progress_bar_unmap (GtkWidget *widget,
+                       gpointer user_data)
+{
+  stop_auto_discard_tick (KASASA_WINDOW (user_data));
 }
 
 static gboolean
@@ -658,44 +912,31 @@ has_modal (KasasaWindow *self)
   return FALSE;
 }
 
-static gboolean
-window_miniaturization_finish (GObject *source_object,
-                               GAsyncResult *result,
-                               GError **error)
-{
-  g_return_val_if_fail (g_task_is_valid (result, source_object), FALSE);
-
-  return g_task_propagate_boolean (G_TASK (result), error);
-}
-
 static void
-window_miniaturization_cb (GObject *source_object,
-                           GAsyncResult *res,
-                           gpointer data)
+window_miniaturization_cb (gpointer user_data)
 {
-  KasasaWindow *self = KASASA_WINDOW (source_object);
-  gboolean miniaturize = window_miniaturization_finish (source_object, res, NULL);
-
-  if (miniaturize && !has_modal (self))
-    {
-      self->window_is_miniaturized = TRUE;
-      gtk_stack_set_visible_child_name (self->stack, "miniature_page");
-      gtk_widget_add_css_class (GTK_WIDGET (self), "circular-window");
-      kasasa_window_resize_window (self, 75, 75);
-    }
-}
+  KasasaWindow *self = KASASA_WINDOW (user_data);
+  g_autoptr (GdkPaintable) thumbnail = NULL;
+  gint thumbnail_size;
 
-static void
-window_miniaturization_thread (GTask *task,
-                               gpointer source_object,
-                               gpointer task_data,
-                               GCancellable *cancellable)
-{
-  sleep (WINDOW_MINIATURIZATION_DELAY);
+  if (has_modal (self))
+    return;
 
-  // If got here, the task was not cancelled, set TRUE to miniaturize
-  // If cancelled, FALSE is silently returned
-  g_task_return_boolean (task, TRUE);
+  // Keep a tiny version of the current content, then release the full ones;
+  // screencasts stay live in the miniature
+  thumbnail_size = WINDOW_MINIATURE_SIZE * gtk_widget_get_scale_factor (GTK_WIDGET (self));
+  thumbnail = kasasa_content_container_get_live_thumbnail (self->content_container,
+                                                           thumbnail_size);
+  if (thumbnail == NULL)
+    thumbnail = GDK_PAINTABLE (kasasa_content_container_get_thumbnail (self->content_container,
+                                                                       thumbnail_size));
+  gtk_picture_set_paintable (self->miniature_picture, thumbnail);
+  kasasa_content_container_trim_contents (self->content_container);
+
+  self->miniaturization_state = MINIATURIZATION_STATE_MINIATURIZED;
+  gtk_stack_set_visible_child_name (self->stack, "miniature_page");
+  gtk_widget_add_css_class (GTK_WIDGET (self), "circular-window");
+  kasasa_window_resize_window (self, WINDOW_MINIATURE_SIZE, WINDOW_MINIATURE_SIZE);
 }
 
 /*
@@ -703,40 +944,40 @@ window_miniaturization_thread (GTask *task,
  *
  * If miniaturize == FALSE, previous requests will be cancelled, and the window
  * will immediately return to its default visual
+ *
+ * The delay is a window timer, so a new request (or a cancellation) simply
+ * reschedules (or disarms) the previous one
  */
 void
 kasasa_window_miniaturize_window (KasasaWindow *self,
                                   gboolean miniaturize)
 {
-  GTask *task = NULL;
-
   g_return_if_fail (KASASA_IS_WINDOW (self));
 
-  // Cancel a (possible) previous request
-  g_cancellable_cancel (self->miniaturization_canceller);
+  // Cancel a (possible) pending request
+  cancel_timer (self, WINDOW_TIMER_MINIATURIZE);
 
   if (miniaturize)
     {
-      if (self->window_is_miniaturized || !g_settings_get_boolean (self->settings, "miniaturize-window") || self->block_miniaturization || gtk_toggle_button_get_active (self->lock_button))
+      if (self->miniaturization_state == MINIATURIZATION_STATE_MINIATURIZED || !self->values->miniaturize_window || self->block_miniaturization || gtk_toggle_button_get_active (self->lock_button))
         return;
 
-      g_object_unref (self->miniaturization_canceller);
-      self->miniaturization_canceller = g_cancellable_new ();
-      task = g_task_new (G_OBJECT (self),
-                         self->miniaturization_canceller,
-                         window_miniaturization_cb, NULL);
-      g_task_set_return_on_cancel (task, TRUE);
-      g_task_run_in_thread (task, window_miniaturization_thread);
-      g_object_unref (task);
+      schedule_timer (self, WINDOW_TIMER_MINIATURIZE,
+                      WINDOW_MINIATURIZATION_DELAY * 1000,
+                      window_miniaturization_cb);
     }
   else
     {
-      if (!self->window_is_miniaturized)
+      if (self->miniaturization_state != MINIATURIZATION_STATE_MINIATURIZED)
         return;
 
-      self->window_is_miniaturized = FALSE;
+      self->miniaturization_state = MINIATURIZATION_STATE_NONE;
       kasasa_content_container_request_window_resize (self->content_container);
+      // Decode the contents while the window is being resized
+      kasasa_content_container_restore_contents (self->content_container);
+      gtk_picture_set_paintable (self->miniature_picture, NULL);
       gtk_widget_remove_css_class (GTK_WIDGET (self), "circular-window");
+      gtk_widget_remove_css_class (GTK_WIDGET (self), "miniature-flash");
       gtk_stack_set_visible_child_name (self->stack, "main_page");
     }
 }
@@ -767,7 +1008,6 @@ static void
 hide_header_bar_cb (gpointer user_data)
 {
   KasasaWindow *self = KASASA_WINDOW (user_data);
-  self->hide_menu_requested = FALSE;
 
   /*
    * Hidding was queried because at some moment the mouse pointer left the window,
@@ -804,18 +1044,13 @@ reveal_header_bar_cb (gpointer user_data)
 static void
 hide_header_bar (KasasaWindow *self)
 {
-  // Hide the vertical menu if this option is enabled
-  if (g_settings_get_boolean (self->settings, "auto-hide-menu"))
-    // As soon as this action has a delay:
-    // if already requested, do nothing; else, request hiding
-    if (self->hide_menu_requested == FALSE)
-      {
-        guint interval = (guint) 1000 * g_settings_get_double (self->settings,
-                                                               "controls-timeout");
-        self->hide_menu_requested = TRUE;
-
-        g_timeout_add_once (interval, hide_header_bar_cb, self);
-      }
+  // Hide the vertical menu if this option is enabled. As soon as this action
+  // has a delay: if already requested, do nothing; else, request hiding
+  if (self->values->auto_hide_menu
+      && !timer_pending (self, WINDOW_TIMER_HIDE_HEADER_BAR))
+    schedule_timer (self, WINDOW_TIMER_HIDE_HEADER_BAR,
+                    (guint) (1000 * self->values->controls_timeout),
+                    hide_header_bar_cb);
 }
 
 static void
@@ -836,10 +1071,10 @@ on_mouse_enter_content_container (GtkEventControllerMotion *event_controller_mot
 
   // Do not reveal HeaderBar/Toolbar if miniaturization is active; this will done
   // after clicking the window
-  if (g_settings_get_boolean (self->settings, "miniaturize-window"))
+  if (self->values->miniaturize_window)
     return;
 
-  if (g_settings_get_boolean (self->settings, "auto-hide-menu"))
+  if (self->values->auto_hide_menu)
     gtk_revealer_set_reveal_child (GTK_REVEALER (self->header_bar_revealer), TRUE);
 
   kasasa_content_container_reveal_controls (self->content_container, TRUE);
@@ -905,10 +1140,10 @@ on_mouse_leave_window (GtkEventControllerMotion *event_controller_motion,
                        gpointer user_data)
 {
   KasasaWindow *self = KASASA_WINDOW (user_data);
-  guint interval = (guint) 1000 * g_settings_get_double (self->settings,
-                                                         "controls-timeout");
 
-  g_timeout_add_once (interval, hide_toolbar_cb, self);
+  schedule_timer (self, WINDOW_TIMER_HIDE_TOOLBAR,
+                  (guint) (1000 * self->values->controls_timeout),
+                  hide_toolbar_cb);
 
   if (gtk_toggle_button_get_active (self->lock_button))
     return;
@@ -929,10 +1164,10 @@ on_window_click_released (GtkGestureClick *gesture_click,
 {
   KasasaWindow *self = KASASA_WINDOW (user_data);
 
-  if (!g_settings_get_boolean (self->settings, "miniaturize-window"))
+  if (!self->values->miniaturize_window)
     return;
 
-  if (g_settings_get_boolean (self->settings, "auto-hide-menu"))
+  if (self->values->auto_hide_menu)
     gtk_revealer_set_reveal_child (GTK_REVEALER (self->header_bar_revealer), TRUE);
 
   kasasa_content_container_reveal_controls (self->content_container, TRUE);
@@ -958,6 +1193,8 @@ on_auto_discard_button_toggled (GtkToggleButton *button,
 
   if (gtk_toggle_button_get_active (button))
     kasasa_window_auto_discard_window (self);
+  else
+    stop_auto_discard_window (self);
 }
 
 static void
@@ -979,15 +1216,15 @@ on_lock_button_toggled (GtkToggleButton *button,
 }
 
 static void
-on_settings_updated (GSettings *settings,
-                     gchar *key,
+on_settings_updated (KasasaSettings *settings,
+                     const gchar *key,
                      gpointer user_data)
 {
   KasasaWindow *self = KASASA_WINDOW (user_data);
 
   if (g_strcmp0 (key, "auto-hide-menu") == 0)
     {
-      gboolean auto_hide = g_settings_get_boolean (self->settings, "auto-hide-menu");
+      gboolean auto_hide = self->values->auto_hide_menu;
 
       if (auto_hide)
         gtk_widget_add_css_class (GTK_WIDGET (self->header_bar), "headerbar-no-dimming");
@@ -997,7 +1234,8 @@ on_settings_updated (GSettings *settings,
       if (auto_hide)
         hide_header_bar (self);
       else
-        g_timeout_add_seconds_once (2, reveal_header_bar_cb, self);
+        schedule_timer (self, WINDOW_TIMER_REVEAL_HEADER_BAR,
+                        2000, reveal_header_bar_cb);
 
       // Resize the window to free/occupy the vertical menu space
       kasasa_content_container_request_window_resize (self->content_container);
@@ -1007,7 +1245,7 @@ on_settings_updated (GSettings *settings,
     {
       // Just change the button state;
       // the button callback signal will trigger the auto discarding
-      if (g_settings_get_boolean (self->settings, "auto-discard-window"))
+      if (self->values->auto_discard_window)
         gtk_toggle_button_set_active (self->auto_discard_button, TRUE);
       else
         gtk_toggle_button_set_active (self->auto_discard_button, FALSE);
@@ -1015,7 +1253,7 @@ on_settings_updated (GSettings *settings,
 
   else if (g_strcmp0 (key, "auto-trash-image") == 0)
     {
-      if (g_settings_get_boolean (self->settings, "auto-trash-image"))
+      if (self->values->auto_trash_image)
         gtk_toggle_button_set_active (self->auto_trash_button, TRUE);
       else
         gtk_toggle_button_set_active (self->auto_trash_button, FALSE);
@@ -1023,7 +1261,7 @@ on_settings_updated (GSettings *settings,
 
   else if (g_strcmp0 (key, "miniaturize-window") == 0)
     {
-      if (g_settings_get_boolean (self->settings, "miniaturize-window"))
+      if (self->values->miniaturize_window)
         kasasa_window_miniaturize_window (self, TRUE);
       else
         kasasa_window_miniaturize_window (self, FALSE);
@@ -1041,14 +1279,75 @@ on_close_request (GtkWindow *window,
   return FALSE;
 }
 
+static void
+kasasa_window_realize (GtkWidget *widget)
+{
+  KasasaWindow *self = KASASA_WINDOW (widget);
+
+  GTK_WIDGET_CLASS (kasasa_window_parent_class)->realize (widget);
+
+  // Keep the display model updated, instead of querying the monitors every
+  // time the window is resized
+  self->surface = g_object_ref (gtk_native_get_surface (GTK_NATIVE (self)));
+  self->monitors = g_object_ref (gdk_display_get_monitors (gtk_widget_get_display (widget)));
+
+  self->monitors_changed_handler_id =
+    g_signal_connect (self->monitors, "items-changed",
+                      G_CALLBACK (on_monitors_changed), self);
+  self->enter_monitor_handler_id =
+    g_signal_connect (self->surface, "enter-monitor",
+                      G_CALLBACK (on_surface_enter_monitor), self);
+  self->scale_handler_id =
+    g_signal_connect (self->surface, "notify::scale",
+                      G_CALLBACK (on_surface_scale_changed), self);
+
+  for (guint i = 0; i < g_list_model_get_n_items (self->monitors); i++)
+    {
+      g_autoptr (GdkMonitor) monitor = g_list_model_get_item (self->monitors, i);
+      watch_monitor (self, monitor);
+    }
+
+  display_model_update_scales (self);
+  display_model_update_monitor (self);
+  display_model_update_scale (self);
+}
+
+static void
+kasasa_window_unrealize (GtkWidget *widget)
+{
+  KasasaWindow *self = KASASA_WINDOW (widget);
+
+  for (guint i = 0; i < g_list_model_get_n_items (self->monitors); i++)
+    {
+      g_autoptr (GdkMonitor) monitor = g_list_model_get_item (self->monitors, i);
+      g_signal_handlers_disconnect_by_data (monitor, self);
+    }
+
+  g_clear_signal_handler (&self->monitors_changed_handler_id, self->monitors);
+  g_clear_signal_handler (&self->enter_monitor_handler_id, self->surface);
+  g_clear_signal_handler (&self->scale_handler_id, self->surface);
+  g_clear_object (&self->monitors);
+  g_clear_object (&self->surface);
+  g_clear_object (&self->display_model.monitor);
+
+  GTK_WIDGET_CLASS (kasasa_window_parent_class)->unrealize (widget);
+}
+
 static void
 kasasa_window_dispose (GObject *kasasa_window)
 {
   KasasaWindow *self = KASASA_WINDOW (kasasa_window);
 
+  g_clear_signal_handler (&self->settings_handler_id, self->settings);
   g_clear_object (&self->settings);
   g_clear_object (&self->window_opacity_animation);
-  g_clear_object (&self->miniaturization_canceller);
+  if (self->opacity_callbacks != NULL)
+    cancel_opacity_callbacks (self);
+  g_clear_pointer (&self->opacity_callbacks, g_array_unref);
+  g_clear_object (&self->resize_animation);
+  destroy_timers (self);
+  g_clear_handle_id (&self->auto_discard_source, g_source_remove);
+  stop_auto_discard_tick (self);
 
   gtk_widget_dispose_template (GTK_WIDGET (kasasa_window), KASASA_TYPE_WINDOW);
 
@@ -1070,6 +1369,9 @@ kasasa_window_class_init (KasasaWindowClass *klass)
   object_class->dispose = kasasa_window_dispose;
   object_class->finalize = kasasa_window_finalize;
 
+  widget_class->realize = kasasa_window_realize;
+  widget_class->unrealize = kasasa_window_unrealize;
+
   gtk_widget_class_set_template_from_resource (widget_class, "/io/github/kelvinnovais/Kasasa/kasasa-window.ui");
   gtk_widget_class_bind_template_child (widget_class, KasasaWindow, content_container);
   gtk_widget_class_bind_template_child (widget_class, KasasaWindow, header_bar_revealer);
@@ -1080,6 +1382,7 @@ kasasa_window_class_init (KasasaWindowClass *klass)
   gtk_widget_class_bind_template_child (widget_class, KasasaWindow, lock_button);
   gtk_widget_class_bind_template_child (widget_class, KasasaWindow, progress_bar);
   gtk_widget_class_bind_template_child (widget_class, KasasaWindow, stack);
+  gtk_widget_class_bind_template_child (widget_class, KasasaWindow, miniature_picture);
 }
 
 static void
@@ -1090,35 +1393,72 @@ kasasa_window_init (KasasaWindow *self)
   GtkEventController *win_motion_event_controller = NULL;
   GtkEventController *win_scroll_event_controller = NULL;
   GtkGesture *win_gesture_click = NULL;
+  AdwAnimationTarget *opacity_target = NULL;
+  AdwAnimationTarget *resize_target = NULL;
 
   g_type_ensure (KASASA_TYPE_CONTENT_CONTAINER);
 
   gtk_widget_init_template (GTK_WIDGET (self));
 
   // Initialize self variables
-  self->settings = g_settings_new ("io.github.kelvinnovais.Kasasa");
-  self->miniaturization_canceller = g_cancellable_new ();
+  self->settings = g_object_ref (kasasa_settings_get_default ());
+  self->values = kasasa_settings_get_values (self->settings);
+  self->miniaturization_state = MINIATURIZATION_STATE_NONE;
   self->hiding_window = FALSE;
-
-  g_signal_connect (self->settings, "changed", G_CALLBACK (on_settings_updated), self);
+  self->first_resize = TRUE;
+
+  // Opacity animation
+  opacity_target =
+    adw_callback_animation_target_new ((AdwAnimationTargetFunc) change_opacity_cb,
+                                       self,
+                                       NULL);
+  self->window_opacity_animation = adw_timed_animation_new (GTK_WIDGET (self),
+                                                            1.0, 1.0,
+                                                            WINDOW_HIDING_DURATION,
+                                                            opacity_target);
+  self->opacity_callbacks = g_array_new (FALSE, FALSE, sizeof (HideWindowCallbackInfo));
+  g_signal_connect (self->window_opacity_animation, "done",
+                    G_CALLBACK (on_opacity_animation_done), self);
+
+  // Resize animation
+  resize_target =
+    adw_callback_animation_target_new ((AdwAnimationTargetFunc) resize_window_cb,
+                                       self,
+                                       NULL);
+  self->resize_animation =
+    adw_spring_animation_new (GTK_WIDGET (self),
+                              0.0, 1.0,
+                              adw_spring_params_new (WINDOW_RESIZING_DAMPING_RATIO,
+                                                     WINDOW_RESIZING_MASS,
+                                                     WINDOW_RESIZING_STIFFNESS),
+                              resize_target);
+  adw_spring_animation_set_clamp (ADW_SPRING_ANIMATION (self->resize_animation),
+                                  TRUE);
+  g_signal_connect (self->resize_animation, "done",
+                    G_CALLBACK (on_resize_animation_done), self);
+
+  self->settings_handler_id = g_signal_connect (self->settings,
+                                                "changed",
+                                                G_CALLBACK (on_settings_updated),
+                                                self);
 
   // PERFFORM ACTIONS ON WIDGETS
   // Auto discard button
-  if (g_settings_get_boolean (self->settings, "auto-discard-window"))
+  if (self->values->auto_discard_window)
     gtk_toggle_button_set_active (self->auto_discard_button, TRUE);
 
   // Auto trash button
-  if (g_settings_get_boolean (self->settings, "auto-trash-image"))
+  if (self->values->auto_trash_image)
     gtk_toggle_button_set_active (self->auto_trash_button, TRUE);
 
-  if (g_settings_get_boolean (self->settings, "auto-hide-menu"))
+  if (self->values->auto_hide_menu)
     {
       gtk_widget_add_css_class (GTK_WIDGET (self->header_bar), "headerbar-no-dimming");
       gtk_revealer_set_reveal_child (GTK_REVEALER (self->header_bar_revealer), FALSE);
     }
 
   // Lock button
-  g_settings_bind (self->settings,
+  g_settings_bind (kasasa_settings_get_gsettings (self->settings),
                    "miniaturize-window",
                    self->lock_button,
                    "visible",
@@ -1193,6 +1533,16 @@ kasasa_window_init (KasasaWindow *self)
                     G_CALLBACK (on_lock_button_toggled),
                     self);
 
+  // Only update the auto discard ProgressBar while it's visible
+  g_signal_connect (self->progress_bar,
+                    "map",
+                    G_CALLBACK (on_progress_bar_map),
+                    self);
+  g_signal_connect (self->progress_bar,
+                    "unmap",
+                    G_CALLBACK (on_progress_bar_unmap),
+                    self);
+
   // Listen to events
   g_signal_connect (GTK_WINDOW (self),
                     "close-request",
@@ -30,12 +30,24 @@ typedef enum
   OPACITY_DECREASE
 } Opacity;
 
+typedef enum
+{
+  MINIATURIZATION_STATE_NONE,
+  MINIATURIZATION_STATE_PENDING,
+  MINIATURIZATION_STATE_MINIATURIZED
+} MiniaturizationState;
+
 #define WINDOW_HIDING_DURATION 110
 #define WINDOW_WAITING_HIDING_DURATION (2 * WINDOW_HIDING_DURATION)
 
+#define WINDOW_MINIATURE_SIZE 75
 #define WINDOW_MINIATURIZATION_DELAY 3
+#define WINDOW_MINIATURE_FLASH_DURATION 1500    // miliseconds
 
-#define WINDOW_RESIZING_DURATION 500
+// Physical parameters of the (critically damped) resizing spring
+#define WINDOW_RESIZING_DAMPING_RATIO 1.0
+#define WINDOW_RESIZING_MASS 1.0
+#define WINDOW_RESIZING_STIFFNESS 200.0
 
 // Due to miniaturization, the real min dimensions are set here (width-request
 // and height-request)
@@ -51,9 +63,12 @@ typedef void (* HideWindowCallback)(gpointer);
 KasasaWindow * kasasa_window_get_window_reference (GtkWidget *widget);
 gboolean kasasa_window_get_trash_button_active (KasasaWindow *window);
 gboolean kasasa_window_is_miniaturized (KasasaWindow *window);
+MiniaturizationState kasasa_window_get_miniaturization_state (KasasaWindow *window);
+gboolean kasasa_window_has_pending_timers (KasasaWindow *window);
 void kasasa_window_hide_window (KasasaWindow           *window,
                                 gboolean                hide,
                                 HideWindowCallback      callback,
+                                HideWindowCallback      cancelled_callback,
                                 gpointer                callback_data);
 void kasasa_window_change_opacity (KasasaWindow *window,
                                    Opacity       opacity_direction);
@@ -68,6 +83,7 @@ void kasasa_window_miniaturize_window (KasasaWindow *window,
                                        gboolean      miniaturize);
 void kasasa_window_block_miniaturization (KasasaWindow *window,
                                           gboolean      block);
+void kasasa_window_flash_miniature (KasasaWindow *window);
 void kasasa_window_take_first_screenshot (KasasaWindow *window);
 
 G_END_DECLS